@@ -0,0 +1,17 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "input_engine.h"
+
+// GpioPort on the Arduino core: inputs use the internal pull-ups, and edges come
+// from attachInterruptArg on CHANGE.
+class ArduinoGpioPort : public GpioPort {
+ public:
+  void configureInput(uint8_t pin) override { pinMode(pin, INPUT_PULLUP); }
+  bool IRAM_ATTR readHigh(uint8_t pin) override { return digitalRead(pin) == HIGH; }
+  void attachEdgeInterrupt(uint8_t pin, void (*isr)(void*), void* arg) override {
+    attachInterruptArg(pin, isr, arg, CHANGE);
+  }
+  uint32_t IRAM_ATTR micros() override { return ::micros(); }
+};
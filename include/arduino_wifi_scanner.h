@@ -0,0 +1,28 @@
+#pragma once
+
+#include <WiFi.h>
+
+#include "channel_planner.h"
+
+// WifiScanner on the Arduino core: one blocking active scan across all channels
+// in station mode, hidden networks included. The caller switches to AP mode
+// afterwards.
+class ArduinoWifiScanner : public WifiScanner {
+ public:
+  static constexpr uint32_t DWELL_MS_PER_CHANNEL = 80;
+
+  int scan(ScannedNetwork* out, size_t capacity) override {
+    WiFi.mode(WIFI_STA);
+    int16_t found = WiFi.scanNetworks(false, true, false, DWELL_MS_PER_CHANNEL);
+    if (found < 0) {
+      return -1;
+    }
+    size_t count = static_cast<size_t>(found) < capacity ? static_cast<size_t>(found) : capacity;
+    for (size_t i = 0; i < count; ++i) {
+      int32_t rssi = WiFi.RSSI(i);
+      out[i] = {static_cast<uint8_t>(WiFi.channel(i)), static_cast<int8_t>(rssi < -128 ? -128 : rssi)};
+    }
+    WiFi.scanDelete();
+    return static_cast<int>(count);
+  }
+};
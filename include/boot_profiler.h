@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Timestamps the end of each startup phase, measured from reset on the given
+// clock, for /debug/boot. Names must be string literals; markOnce() compares them
+// by address. Marks beyond MaxMarks are counted but not kept.
+template <size_t MaxMarks>
+class BootProfiler {
+ public:
+  using Clock = uint32_t (*)();
+
+  struct Mark {
+    const char* name;
+    uint32_t atUs;
+  };
+
+  explicit BootProfiler(Clock clockUs) : clockUs_(clockUs) {}
+
+  void mark(const char* name) {
+    if (count_ == MaxMarks) {
+      ++overflows_;
+      return;
+    }
+    marks_[count_++] = {name, clockUs_()};
+  }
+
+  // Marks a one-off event (the first request served, say) the first time only.
+  void markOnce(const char* name) {
+    for (size_t i = 0; i < count_; ++i) {
+      if (marks_[i].name == name) {
+        return;
+      }
+    }
+    mark(name);
+  }
+
+  size_t count() const { return count_; }
+  const Mark& markAt(size_t index) const { return marks_[index]; }
+  uint32_t overflows() const { return overflows_; }
+
+ private:
+  Clock clockUs_;
+  Mark marks_[MaxMarks] = {};
+  size_t count_ = 0;
+  uint32_t overflows_ = 0;
+};
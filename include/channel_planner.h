@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// One access point heard by a scan.
+struct ScannedNetwork {
+  uint8_t channel;
+  int8_t rssi;  // dBm
+};
+
+// Radio access used by ChannelPlanner. The firmware binds it to the Arduino WiFi
+// scan (ArduinoWifiScanner in arduino_wifi_scanner.h); a native build can
+// substitute a fixed survey of a venue.
+class WifiScanner {
+ public:
+  virtual ~WifiScanner() = default;
+  // Fills out with up to capacity networks; returns how many, or -1 when the
+  // scan failed.
+  virtual int scan(ScannedNetwork* out, size_t capacity) = 0;
+};
+
+// Picks the 2.4 GHz channel with the least competing traffic for the hub's
+// access point. Every network heard adds to the score of its own channel and,
+// less and less, to the four channels either side that its 20 MHz signal
+// overlaps; louder networks add more. The lowest score wins. Ties go to 1, 6
+// and 11 (which do not overlap each other), then to the fallback channel.
+// Channels stop at 11, the highest one allowed everywhere.
+class ChannelPlanner {
+ public:
+  static constexpr uint8_t MIN_CHANNEL = 1;
+  static constexpr uint8_t MAX_CHANNEL = 11;
+  static constexpr size_t MAX_NETWORKS = 48;
+
+  explicit ChannelPlanner(WifiScanner& scanner) : scanner_(scanner) {}
+
+  // Scans and returns the best channel, or fallbackChannel when the scan failed.
+  uint8_t plan(uint8_t fallbackChannel);
+
+  // Congestion score of channel given the networks heard; lower is better.
+  static uint32_t score(const ScannedNetwork* networks, size_t count, uint8_t channel);
+  // Best channel for precomputed scores, indexed by channel number.
+  static uint8_t best(const uint32_t* scores, uint8_t fallbackChannel);
+
+  bool scanned() const { return scanned_; }
+  size_t networkCount() const { return networkCount_; }
+  uint32_t scoreOf(uint8_t channel) const { return scores_[channel]; }
+
+ private:
+  WifiScanner& scanner_;
+  bool scanned_ = false;
+  size_t networkCount_ = 0;
+  uint32_t scores_[MAX_CHANNEL + 1] = {};
+};
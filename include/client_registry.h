@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "latency_histogram.h"
+
+// Who is talking to the hub and how it is faring, for /debug/clients and the GM
+// display list. A client is an IP address plus the id its script sends with
+// requests (the DCD's display id, the GM panel's own); requests without an id,
+// such as page and asset loads, count towards the entry last seen from that IP.
+// The table is fixed: when it is full, the client silent the longest is evicted.
+// Telemetry the scripts report about themselves is kept per client and summed
+// over all clients, evicted ones included.
+class ClientRegistry {
+ public:
+  static constexpr size_t MAX_CLIENTS = 16;
+  static constexpr size_t ID_LENGTH = 8;
+
+  // What a script measured on its side of the link, from /telemetry beacons.
+  struct Telemetry {
+    LatencyHistogram fetchMs;   // Request to response, for every fetch the script made.
+    LatencyHistogram renderMs;  // Response to painted frame.
+    uint32_t droppedFrames;
+    uint32_t errors;            // Failed or non-2xx fetches and socket drops.
+    uint32_t reports;
+  };
+
+  struct Client {
+    uint32_t ip;  // Network byte order; 0 marks a free slot.
+    char id[ID_LENGTH + 1];
+    uint32_t firstSeenMs;
+    uint32_t lastSeenMs;
+    uint32_t requests;
+    uint32_t bytes;     // Response bodies.
+    uint32_t errors;    // Responses with status 400 and up, including 503 sheds.
+    uint32_t polls;
+    uint32_t lastPollMs;
+    uint32_t pollIntervalMs;  // Smoothed time between polls.
+    uint16_t renderMs;        // Latest poll-to-paint time the client reported.
+    uint16_t maxRenderMs;
+    Telemetry telemetry;
+  };
+
+  // Finds the client, claiming a slot for a new one. id may be empty.
+  Client& lookup(uint32_t ip, const char* id, uint32_t nowMs);
+  void recordRequest(Client& client, bool poll, size_t bytes, int status, uint32_t nowMs);
+  void recordRenderLatency(Client& client, uint32_t renderMs);
+  // Adds one beacon's counts to the client and to the totals.
+  void recordTelemetry(Client& client, const Telemetry& report);
+
+  // The client that sent id most recently, or null.
+  const Client* findById(const char* id) const;
+  size_t capacity() const { return MAX_CLIENTS; }
+  const Client& at(size_t index) const { return clients_[index]; }
+  uint32_t evictions() const { return evictions_; }
+  const Telemetry& totals() const { return totals_; }
+
+ private:
+  Client& claim(uint32_t ip, const char* id, uint32_t nowMs);
+
+  Client clients_[MAX_CLIENTS] = {};
+  uint32_t evictions_ = 0;
+  Telemetry totals_ = {};
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Cooperative scheduler for the loop task. Jobs run in registration order (put
+// the most latency-sensitive first), each at most once per runOnce() and no more
+// often than its period. Every job gets a time budget: it is handed the deadline
+// so draining jobs can stop early, and any run that goes over is counted against
+// the job. Per-job and per-pass timings are kept for /debug/jobs.
+template <size_t MaxJobs>
+class CooperativeScheduler {
+ public:
+  // deadlineUs is a clock value; compare with (int32_t)(deadlineUs - now) > 0.
+  using JobFunction = void (*)(void* context, uint32_t deadlineUs);
+  using Clock = uint32_t (*)();
+
+  struct JobStats {
+    const char* name;
+    uint32_t periodMs;
+    uint32_t budgetUs;
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t lastUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+  };
+
+  struct PassStats {
+    uint32_t passes;
+    uint32_t lastUs;
+    uint32_t maxUs;
+  };
+
+  explicit CooperativeScheduler(Clock clockUs) : clockUs_(clockUs) {}
+
+  // periodMs = 0 runs the job on every pass.
+  bool addJob(const char* name, JobFunction function, void* context, uint32_t periodMs, uint32_t budgetUs) {
+    if (count_ == MaxJobs) {
+      return false;
+    }
+    Job& job = jobs_[count_++];
+    job.function = function;
+    job.context = context;
+    job.hasRun = false;
+    job.stats = {name, periodMs, budgetUs, 0, 0, 0, 0, 0};
+    return true;
+  }
+
+  void runOnce() {
+    uint32_t passStart = clockUs_();
+    for (size_t i = 0; i < count_; ++i) {
+      Job& job = jobs_[i];
+      uint32_t start = clockUs_();
+      if (job.hasRun && start - job.lastStartUs < job.stats.periodMs * 1000u) {
+        continue;
+      }
+      job.hasRun = true;
+      job.lastStartUs = start;
+      job.function(job.context, start + job.stats.budgetUs);
+      uint32_t elapsed = clockUs_() - start;
+      JobStats& stats = job.stats;
+      ++stats.runs;
+      stats.lastUs = elapsed;
+      stats.totalUs += elapsed;
+      if (elapsed > stats.maxUs) {
+        stats.maxUs = elapsed;
+      }
+      if (elapsed > stats.budgetUs) {
+        ++stats.overruns;
+      }
+    }
+    uint32_t passElapsed = clockUs_() - passStart;
+    ++pass_.passes;
+    pass_.lastUs = passElapsed;
+    if (passElapsed > pass_.maxUs) {
+      pass_.maxUs = passElapsed;
+    }
+  }
+
+  // True while the job's deadline has not passed.
+  bool withinBudget(uint32_t deadlineUs) const { return static_cast<int32_t>(deadlineUs - clockUs_()) > 0; }
+
+  size_t jobCount() const { return count_; }
+  const JobStats& jobStats(size_t index) const { return jobs_[index].stats; }
+  const PassStats& passStats() const { return pass_; }
+
+ private:
+  struct Job {
+    JobFunction function;
+    void* context;
+    bool hasRun;
+    uint32_t lastStartUs;
+    JobStats stats;
+  };
+
+  Clock clockUs_;
+  Job jobs_[MaxJobs] = {};
+  size_t count_ = 0;
+  PassStats pass_ = {};
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Game event kinds recorded in the event log. Values are part of the binary
+// record format streamed to GM panels, so only ever append new ones.
+enum class GameEventType : uint8_t {
+  Transition = 1,      // a = previous GameState, b = new GameState
+  ButtonPress = 2,     // a = pressed button, b = expected button (0 outside Puzzle 3), c = progress after
+  ConduitConfirm = 3,  // a = ConduitConfirmResult
+  LatchFired = 4,
+  Reset = 5,           // a = GameState before the reset
+  RemoteButton = 6,    // a = remote letter
+  ClockChanged = 7,    // a = action ('s','p','u','d','r','e'), b:c = minutes:seconds left
+  Restored = 8,        // a = GameState restored after a reset, b = GameSnapshotStore::Source
+};
+
+// Fixed 12-byte record; streamed to GM panels as-is (little-endian).
+struct __attribute__((packed)) GameEvent {
+  uint32_t seq;
+  uint32_t timestampMs;
+  uint8_t type;
+  uint8_t a;
+  uint8_t b;
+  uint8_t c;
+};
+static_assert(sizeof(GameEvent) == 12, "GameEvent is a wire format");
+
+// Ring of the most recent game events. Every event gets a monotonically
+// increasing sequence number that readers use as a cursor: reading from a cursor
+// returns only what was appended since, and a cursor that fell out of the ring
+// resumes at the oldest retained event.
+template <size_t Capacity>
+class EventLog {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+ public:
+  const GameEvent& append(GameEventType type, uint32_t timestampMs, uint8_t a = 0, uint8_t b = 0,
+                          uint8_t c = 0) {
+    GameEvent& event = events_[nextSeq_ & (Capacity - 1)];
+    event.seq = nextSeq_++;
+    event.timestampMs = timestampMs;
+    event.type = static_cast<uint8_t>(type);
+    event.a = a;
+    event.b = b;
+    event.c = c;
+    return event;
+  }
+
+  uint32_t nextSeq() const { return nextSeq_; }
+
+  uint32_t oldestSeq() const { return nextSeq_ > Capacity ? nextSeq_ - Capacity : 0; }
+
+  // Copies up to maxEvents events starting at cursor into out and advances the
+  // cursor past them. Sets dropped when events between the cursor and the oldest
+  // retained event were overwritten before the reader got to them, or when the
+  // cursor is ahead of the log and cannot have come from it.
+  size_t read(uint32_t& cursor, GameEvent* out, size_t maxEvents, bool& dropped) const {
+    dropped = cursor < oldestSeq() || cursor > nextSeq_;
+    if (dropped) {
+      cursor = oldestSeq();
+    }
+    size_t count = 0;
+    while (cursor < nextSeq_ && count < maxEvents) {
+      memcpy(&out[count++], &events_[cursor & (Capacity - 1)], sizeof(GameEvent));
+      ++cursor;
+    }
+    return count;
+  }
+
+ private:
+  GameEvent events_[Capacity] = {};
+  uint32_t nextSeq_ = 0;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <Preferences.h>
+
+// What the room needs to carry on after a reset: the game's progress and the
+// mission clock. Field meanings follow the globals in main.cpp; decode() only
+// checks that the record is intact, main.cpp validates the values.
+struct GameSnapshot {
+  uint8_t state;  // GameState
+  bool conduitsVerified;
+  bool latchTriggered;
+  uint8_t nextSequenceIndex;
+  bool clockRunning;
+  uint16_t clockSeconds;  // Seconds left on the mission clock, rounded up.
+
+  bool sameGame(const GameSnapshot& other) const {
+    return state == other.state && conduitsVerified == other.conduitsVerified &&
+           latchTriggered == other.latchTriggered && nextSequenceIndex == other.nextSequenceIndex &&
+           clockRunning == other.clockRunning;
+  }
+};
+
+// Keeps the latest snapshot in two places. RTC memory is not cleared by a
+// watchdog, panic or software reset and costs nothing to write, so it gets every
+// change. NVS also survives power loss but wears the flash, so writes to it are
+// coalesced: a game change goes out COALESCE_MS after it was made, together with
+// everything that changed meanwhile, and a running clock on its own is only
+// refreshed every CLOCK_REFRESH_MS.
+class GameSnapshotStore {
+ public:
+  static constexpr uint8_t FORMAT_VERSION = 1;
+  static constexpr size_t RECORD_SIZE = 8;
+  static constexpr uint32_t COALESCE_MS = 2000;
+  static constexpr uint32_t CLOCK_REFRESH_MS = 60000;
+
+  enum class Source : uint8_t { None, Rtc, Nvs };
+
+  struct Stats {
+    uint32_t saves;      // Snapshots that differed from the previous one.
+    uint32_t nvsWrites;
+    uint32_t nvsErrors;
+    Source restoredFrom;
+  };
+
+  bool begin();
+  // Loads the freshest intact snapshot; false when neither copy is usable.
+  bool restore(GameSnapshot& snapshot);
+  // Records snapshot if it changed. Cheap enough to call on every state change.
+  void save(const GameSnapshot& snapshot, uint32_t nowMs);
+  // Writes a pending snapshot to NVS once it is due; call periodically.
+  void flush(uint32_t nowMs);
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  static void encode(const GameSnapshot& snapshot, uint8_t* record);
+  static bool decode(const uint8_t* record, GameSnapshot& snapshot);
+
+  Preferences prefs_;
+  bool ready_ = false;
+  GameSnapshot last_ = {};
+  bool hasLast_ = false;
+  bool gamePending_ = false;
+  bool clockPending_ = false;
+  uint32_t gameChangedMs_ = 0;
+  uint32_t lastNvsWriteMs_ = 0;
+  Stats stats_ = {};
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <LittleFS.h>
+
+#include "event_log.h"
+
+// Append-only game history on LittleFS for post-show analysis. Every session (a
+// game, from boot or a GM reset to the next reset) is one file under /history:
+// a FileHeader followed by GameEvent records exactly as the event log holds
+// them. Records collect in a RAM page and reach flash one page at a time, or
+// after FLUSH_AFTER_MS for a page that is slow to fill, so the flash is written
+// rarely and never from a request handler's hot path. Only the newest
+// MAX_SESSIONS files are kept.
+class HistoryLog {
+ public:
+  static constexpr size_t PAGE_SIZE = 256;
+  static constexpr size_t RECORDS_PER_PAGE = PAGE_SIZE / sizeof(GameEvent);
+  static constexpr size_t MAX_SESSIONS = 8;
+  static constexpr uint32_t FLUSH_AFTER_MS = 10000;
+  static constexpr uint8_t FORMAT_VERSION = 1;
+
+  struct __attribute__((packed)) FileHeader {
+    char magic[4];  // "HIST"
+    uint8_t version;
+    uint8_t recordSize;
+    uint16_t reserved;
+    uint32_t session;
+    uint32_t bootId;  // Boot that opened the file; timestamps restart at each boot.
+  };
+  static_assert(sizeof(FileHeader) == 16, "FileHeader is a file format");
+
+  struct Stats {
+    uint32_t records;
+    uint32_t pageWrites;
+    uint32_t partialWrites;  // Pages written early by the FLUSH_AFTER_MS deadline.
+    uint32_t writeErrors;
+    uint32_t gaps;           // Times the event log overwrote records before they were collected.
+    uint32_t maxWriteUs;
+  };
+
+  // Mounts the filesystem (formatting it on first use) and opens a session.
+  // continueLastSession appends to the newest file instead of starting one,
+  // for a boot that resumed a game in progress.
+  bool begin(uint32_t bootId, bool continueLastSession);
+  // Flushes the current session and starts the next one.
+  bool startSession();
+
+  bool full() const { return count_ == RECORDS_PER_PAGE; }
+  // Buffers one record; false when the page is full and must be flushed first.
+  bool add(const GameEvent& event, uint32_t nowMs);
+  void noteGap() { ++stats_.gaps; }
+  bool flushDue(uint32_t nowMs) const;
+  // Writes the buffered records, full page or not.
+  bool flush();
+
+  bool ready() const { return ready_; }
+  uint32_t currentSession() const { return session_; }
+  uint32_t firstSession() const { return session_ > MAX_SESSIONS ? session_ - MAX_SESSIONS + 1 : 1; }
+  // Opens a session file for reading; the current one should be flushed first.
+  bool openSession(uint32_t session, File& file) const;
+  const Stats& stats() const { return stats_; }
+
+ private:
+  static void sessionPath(uint32_t session, char* out, size_t size);
+  bool openFile(bool create);
+
+  bool ready_ = false;
+  uint32_t bootId_ = 0;
+  uint32_t session_ = 0;
+  File file_;
+  GameEvent page_[RECORDS_PER_PAGE];
+  size_t count_ = 0;
+  uint32_t firstBufferedMs_ = 0;
+  Stats stats_ = {};
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Scheduling class of a request, most urgent first. GM inputs must never wait
+// behind display polls, and polls must never wait behind page and asset loads.
+enum class RequestPriority : uint8_t { Control, Poll, Page };
+constexpr size_t REQUEST_PRIORITY_CLASSES = 3;
+
+// Fills out with up to capacity bytes of a streamed body; returns the number
+// written, 0 when the source failed or ran dry early.
+using HttpBodyReader = size_t (*)(void* context, uint8_t* out, size_t capacity);
+
+// Response sink shared by both HTTP server builds (Arduino WebServer and the
+// HubHttpServer connection pool), so route handlers never depend on which one
+// is compiled in.
+class HttpResponse {
+ public:
+  virtual ~HttpResponse() = default;
+
+  // Sends a complete response, copying the body; it may live on the caller's stack.
+  // extraHeaders holds zero or more "Name: value\r\n" lines.
+  virtual void send(int status, const char* contentType, const char* body, size_t length,
+                    const char* extraHeaders) = 0;
+
+  // Sends a complete response whose body is referenced rather than copied, so it
+  // must stay valid until the response is written (flash-resident assets).
+  virtual void sendStatic(int status, const char* contentType, const uint8_t* body, size_t length,
+                          const char* extraHeaders) = 0;
+
+  // Sends a response whose length bytes of body are pulled from reader in chunks
+  // while they are written, so bodies larger than RAM (flash files) can be served.
+  // A reader that comes up short ends the response by closing the connection.
+  virtual void sendStream(int status, const char* contentType, size_t length, HttpBodyReader reader,
+                          void* context, const char* extraHeaders) = 0;
+
+  void send(int status, const char* contentType, const char* body) {
+    send(status, contentType, body, strlen(body), "");
+  }
+};
+
+// Passes a response through to another one and remembers its status and body
+// size, so the dispatcher can account for it per client.
+class MeteredResponse : public HttpResponse {
+ public:
+  explicit MeteredResponse(HttpResponse& inner) : inner_(inner) {}
+
+  using HttpResponse::send;
+  void send(int status, const char* contentType, const char* body, size_t length,
+            const char* extraHeaders) override {
+    note(status, length);
+    inner_.send(status, contentType, body, length, extraHeaders);
+  }
+  void sendStatic(int status, const char* contentType, const uint8_t* body, size_t length,
+                  const char* extraHeaders) override {
+    note(status, length);
+    inner_.sendStatic(status, contentType, body, length, extraHeaders);
+  }
+  void sendStream(int status, const char* contentType, size_t length, HttpBodyReader reader, void* context,
+                  const char* extraHeaders) override {
+    note(status, length);
+    inner_.sendStream(status, contentType, length, reader, context, extraHeaders);
+  }
+
+  int status() const { return status_; }
+  size_t bodyBytes() const { return bodyBytes_; }
+
+ private:
+  void note(int status, size_t length) {
+    status_ = status;
+    bodyBytes_ += length;
+  }
+
+  HttpResponse& inner_;
+  int status_ = 0;
+  size_t bodyBytes_ = 0;
+};
+
+const char* httpStatusReason(int status);
+
+// Formats the status line and headers of a response. 204 and 304 carry no
+// Content-Type or Content-Length. Returns the header length, or 0 when it does
+// not fit in out.
+size_t formatResponseHead(char* out, size_t size, int status, const char* contentType, size_t contentLength,
+                          const char* extraHeaders, bool keepAlive);
+
+// Decodes %XX escapes and '+' in place; returns the decoded length.
+size_t urlDecodeInPlace(char* text, size_t length);
+
+// Splits a raw query string ("a=1&b=two") and calls callback(name, value) with
+// each pair URL-decoded and NUL-terminated. Pairs longer than the scratch buffer
+// are cut short, which the caller's own length checks then reject.
+template <typename Callback>
+void forEachQueryArg(const char* query, size_t length, Callback&& callback) {
+  char pair[160];
+  size_t start = 0;
+  while (start < length) {
+    size_t end = start;
+    while (end < length && query[end] != '&') {
+      ++end;
+    }
+    size_t pairLength = end - start;
+    if (pairLength >= sizeof(pair)) {
+      pairLength = sizeof(pair) - 1;
+    }
+    if (pairLength > 0) {
+      memcpy(pair, query + start, pairLength);
+      pair[pairLength] = '\0';
+      char* value = strchr(pair, '=');
+      if (value != nullptr) {
+        *value++ = '\0';
+      } else {
+        value = pair + pairLength;
+      }
+      urlDecodeInPlace(pair, strlen(pair));
+      urlDecodeInPlace(value, strlen(value));
+      callback(pair, value);
+    }
+    start = end + 1;
+  }
+}
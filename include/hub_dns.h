@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+// Minimal authoritative DNS responder for the hub's access point. Clients get
+// their DNS server from the AP's DHCP, so every lookup lands here: the hub's own
+// name and the OS connectivity-probe hosts resolve to the AP address, and every
+// other name is answered NXDOMAIN at once instead of timing out upstream. Queries
+// are answered in place in a fixed packet buffer; nothing is allocated.
+class HubDnsResponder {
+ public:
+  static constexpr uint16_t PORT = 53;
+  static constexpr size_t MAX_PACKET_SIZE = 512;
+  static constexpr uint32_t ANSWER_TTL_S = 300;
+  // Bounds the time one call may spend when a client floods the port.
+  static constexpr size_t MAX_QUERIES_PER_CALL = 4;
+
+  struct Stats {
+    uint32_t queries;
+    uint32_t answered;  // Known name, A record returned.
+    uint32_t noData;    // Known name, other record type: empty NOERROR.
+    uint32_t nxDomain;
+    uint32_t malformed;
+  };
+
+  // names must outlive the responder; they are compared case-insensitively.
+  bool begin(IPAddress address, const char* const* names, size_t nameCount);
+  void processQueries();
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  size_t answer(size_t length);
+  bool isKnownName(const char* name) const;
+
+  WiFiUDP udp_;
+  uint8_t address_[4] = {};
+  const char* const* names_ = nullptr;
+  size_t nameCount_ = 0;
+  Stats stats_ = {};
+  uint8_t packet_[MAX_PACKET_SIZE];
+};
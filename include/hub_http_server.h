@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "http_common.h"
+#include "route_table.h"
+
+// Build-time choice of HTTP server: the Arduino WebServer (one client at a time,
+// String-based) or HubHttpServer below. Select with -DHUB_HTTP_SERVER=...; see the
+// upesy_wroom_hubhttp environment in platformio.ini.
+#define HUB_HTTP_SERVER_WEBSERVER 0
+#define HUB_HTTP_SERVER_HUBHTTP 1
+#ifndef HUB_HTTP_SERVER
+#define HUB_HTTP_SERVER HUB_HTTP_SERVER_WEBSERVER
+#endif
+
+// A parsed request. Every pointer refers into the connection's receive buffer
+// and is only valid for the duration of the dispatch call.
+struct HubHttpRequest {
+  HttpMethod method;
+  const char* path;
+  size_t pathLength;
+  const char* query;  // URL query string, or the form body of a POST.
+  size_t queryLength;
+  const char* ifNoneMatch;  // Empty when the header is absent.
+  uint32_t remoteIp;        // IPv4 address in network byte order.
+};
+
+using HubHttpDispatch = void (*)(const HubHttpRequest& request, HttpResponse& response);
+// Classifies a request from its request line alone, before it is parsed further.
+using HubHttpClassify = RequestPriority (*)(HttpMethod method, const char* path, size_t pathLength);
+
+// Minimal HTTP/1.1 server on lwIP sockets for the hub. A fixed pool of connection
+// slots with preallocated receive/transmit buffers serves keep-alive and
+// pipelined requests without touching the heap: requests are parsed in place,
+// small dynamic bodies are copied into the slot's transmit buffer and static
+// bodies are written straight from flash. Every socket is non-blocking with
+// TCP_NODELAY, and handleClient() services all slots once per call.
+//
+// Each call first reads from every slot, then serves the complete requests it
+// holds in priority order: all Control requests, then Poll, then at most
+// PAGE_REQUESTS_PER_PASS Page requests. Page loads left over wait for the next
+// call, so a burst of display reloads cannot delay a GM command by more than one
+// page response.
+class HubHttpServer {
+ public:
+  static constexpr size_t MAX_CONNECTIONS = 6;
+  static constexpr size_t RX_BUFFER_SIZE = 1024;
+  static constexpr size_t TX_BUFFER_SIZE = 1536;
+  static constexpr unsigned long IDLE_TIMEOUT_MS = 5000;
+  // A request must arrive in full this soon after its first byte.
+  static constexpr unsigned long REQUEST_TIMEOUT_MS = 3000;
+  // Bounds how long a response larger than the transmit buffer may stall the loop.
+  static constexpr unsigned long BLOCKING_FLUSH_LIMIT_MS = 500;
+  static constexpr uint16_t MAX_REQUESTS_PER_CONNECTION = 500;
+  static constexpr size_t PAGE_REQUESTS_PER_PASS = 2;
+
+  struct Stats {
+    uint32_t accepted;
+    uint32_t requests;
+    uint32_t pipelined;
+    uint32_t evictedIdle;
+    uint32_t timedOut;  // Idle keep-alive connections and requests that stalled part way.
+    uint32_t malformed;
+    uint32_t socketErrors;
+    uint32_t deferred;  // Complete page requests held back to a later pass by the page budget.
+    uint32_t served[REQUEST_PRIORITY_CLASSES];
+  };
+
+  explicit HubHttpServer(uint16_t port) : port_(port) {}
+
+  void onRequest(HubHttpDispatch dispatch) { dispatch_ = dispatch; }
+  // Without a classifier every request is served as Poll.
+  void onClassify(HubHttpClassify classify) { classify_ = classify; }
+  bool begin();
+  void handleClient();
+
+  size_t activeConnections() const;
+  // Passes in a row that ended with requests still held back by the page budget:
+  // sustained page load, as opposed to one page pulling in its assets.
+  uint32_t pageBacklogPasses() const { return pageBacklogPasses_; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  class Connection : public HttpResponse {
+   public:
+    using HttpResponse::send;
+    void send(int status, const char* contentType, const char* body, size_t length,
+              const char* extraHeaders) override;
+    void sendStatic(int status, const char* contentType, const uint8_t* body, size_t length,
+                    const char* extraHeaders) override;
+    void sendStream(int status, const char* contentType, size_t length, HttpBodyReader reader, void* context,
+                    const char* extraHeaders) override;
+
+    bool active() const { return fd >= 0; }
+    bool hasPendingOutput() const { return txSent < txLength || staticRemaining > 0; }
+    bool flush();
+    void flushBlocking();
+    void append(const uint8_t* data, size_t length);
+    bool writeHead(int status, const char* contentType, size_t contentLength, const char* extraHeaders);
+
+    int fd = -1;
+    uint32_t remoteIp = 0;
+    unsigned long lastActivityMs = 0;
+    unsigned long requestStartMs = 0;  // When the request at the front of rx began to arrive.
+    uint16_t requests = 0;
+    bool keepAlive = false;
+    bool responded = false;
+    bool servedThisPass = false;
+    bool awaitingBody = false;  // The front request's headers are in but not all of its body.
+    bool failed = false;  // Write error or a response cut short; the connection is closed, never reused.
+    size_t rxLength = 0;
+    size_t txLength = 0;
+    size_t txSent = 0;
+    const uint8_t* staticBody = nullptr;
+    size_t staticRemaining = 0;
+    char rx[RX_BUFFER_SIZE + 1];
+    uint8_t tx[TX_BUFFER_SIZE];
+  };
+
+  void acceptConnections();
+  Connection* freeSlot();
+  Connection* longestIdleSlot();
+  bool receive(Connection& connection);
+  bool partialRequest(const Connection& connection) const;
+  bool requestComplete(const Connection& connection) const;
+  bool pendingPriority(const Connection& connection, RequestPriority& priority) const;
+  size_t servePending(Connection& connection, RequestPriority priority, size_t budget);
+  bool processRequest(Connection& connection);
+  void rejectRequest(Connection& connection, int status);
+  void close(Connection& connection);
+
+  uint16_t port_;
+  int listenFd_ = -1;
+  HubHttpDispatch dispatch_ = nullptr;
+  HubHttpClassify classify_ = nullptr;
+  Stats stats_ = {};
+  uint32_t pageBacklogPasses_ = 0;
+  Connection connections_[MAX_CONNECTIONS];
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "spsc_queue.h"
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+// Hardware access used by InputEngine. The firmware binds it to the Arduino GPIO
+// calls (ArduinoGpioPort in arduino_gpio.h); a native build can substitute a
+// port that replays recorded or synthetic edge traces.
+class GpioPort {
+ public:
+  virtual ~GpioPort() = default;
+  virtual void configureInput(uint8_t pin) = 0;
+  virtual bool readHigh(uint8_t pin) = 0;
+  // isr(arg) must run on every edge of pin.
+  virtual void attachEdgeInterrupt(uint8_t pin, void (*isr)(void*), void* arg) = 0;
+  virtual uint32_t micros() = 0;
+};
+
+// Physical button input. Three stages, each in its own context:
+//
+//   1. Edge ISR: captureEdge() stamps the pin level and time into a lock-free
+//      edge queue. Nothing else happens in interrupt context.
+//   2. process(), from the input task: drains edges through a per-button
+//      debounce and the global press rate cap. An accepted press goes to the
+//      press hook at once (the latch fast path) and into the press queue.
+//      Presses without an edge (wireless buttons) arrive through injectPress()
+//      and are merged in by timestamp, then take the same rate cap and hook.
+//      What became of each one is reported back through nextInjectResult().
+//   3. peekPress()/donePress(), from the loop: hand accepted presses to the game.
+//      A press stays queued until the game has applied it, so the hook can tell
+//      whether earlier presses are still on their way (pressesPending()).
+//
+// Debouncing accepts the first edge of a press immediately and then ignores the
+// button for debounceUs; when that window closes, the pin is read again and any
+// change missed in the bounce is applied. A press made sooner than
+// minPressIntervalUs after the previous accepted press (of any button) is
+// dropped and counted, which caps how fast mashing players can enter input.
+class InputEngine {
+ public:
+  static constexpr size_t MAX_BUTTONS = 8;
+  static constexpr size_t EDGE_QUEUE_CAPACITY = 64;
+  static constexpr size_t PRESS_QUEUE_CAPACITY = 16;
+  static constexpr size_t INJECT_QUEUE_CAPACITY = 16;
+
+  struct Config {
+    uint32_t debounceUs;
+    uint32_t minPressIntervalUs;
+    bool activeLow;  // Buttons pull the pin to ground.
+  };
+
+  struct Press {
+    uint8_t button;  // 1-based, in the order of the pins given to the constructor.
+    uint32_t timestampUs;
+  };
+
+  struct Stats {
+    uint32_t edges;
+    uint32_t edgeOverflows;
+    uint32_t bounces;      // Edges swallowed inside a debounce window.
+    uint32_t resyncs;      // Level changes found by the post-window re-read.
+    uint32_t presses;
+    uint32_t rateLimited;  // Presses dropped by the rate cap.
+    uint32_t pressOverflows;
+    uint32_t injected;         // Presses taken from injectPress(), before the rate cap.
+    uint32_t injectOverflows;  // injectPress() calls refused by a full queue.
+  };
+
+  // What process() did with an injected press.
+  enum class InjectOutcome : uint8_t {
+    Accepted,     // Queued for the game.
+    RateLimited,  // Too soon after the previous accepted press; dropped.
+    Overflow,     // The press queue was full; dropped.
+  };
+
+  struct InjectResult {
+    uint8_t tag;  // As given to injectPress().
+    InjectOutcome outcome;
+  };
+
+  using PressHook = void (*)(void* context, const Press& press);
+
+  InputEngine(GpioPort& gpio, const uint8_t* pins, size_t count, const Config& config);
+
+  void onPress(PressHook hook, void* context) {
+    pressHook_ = hook;
+    pressHookContext_ = context;
+  }
+  // Called from the ISR after each captured edge, e.g. to wake the input task.
+  void onEdge(void (*notify)(void*), void* context) {
+    edgeNotify_ = notify;
+    edgeNotifyContext_ = context;
+  }
+
+  // Configures the pins, samples their idle levels and attaches the edge ISRs.
+  void begin();
+
+  void captureEdge(uint8_t index);
+  // Queues a press that has no GPIO edge for the next process(). Call from one
+  // task only; false for an unknown button or when the queue is full. The
+  // caller's tag comes back with the press's InjectResult.
+  bool injectPress(uint8_t button, uint32_t timestampUs, uint8_t tag = 0);
+  void process();
+  // Outcomes of injected presses, in the order process() took them. Read from
+  // the task that injects; at most INJECT_QUEUE_CAPACITY are held, so a caller
+  // that keeps no more presses than that outstanding never loses one.
+  bool nextInjectResult(InjectResult& result) { return injectResults_.pop(result); }
+  // The oldest press the game has not finished with; it stays queued until
+  // donePress().
+  bool peekPress(Press& press) const { return presses_.peek(press); }
+  void donePress() {
+    Press press;
+    presses_.pop(press);
+  }
+  // For the press hook: true while earlier presses are queued or being applied.
+  bool pressesPending() const { return !presses_.empty(); }
+
+  // True while a debounce window is open; process() must run again once it closes.
+  bool hasOpenWindows() const;
+  Stats stats() const;
+
+ private:
+  struct Edge {
+    uint8_t index;
+    bool high;
+    uint32_t timestampUs;
+  };
+
+  struct Injection {
+    uint8_t button;
+    uint8_t tag;
+    uint32_t timestampUs;
+  };
+
+  struct Button {
+    InputEngine* engine;
+    uint8_t index;
+    uint8_t pin;
+    bool pressed;
+    bool windowOpen;
+    uint32_t windowStartUs;
+  };
+
+  static void edgeIsr(void* button);
+  bool isActive(bool high) const { return high != config_.activeLow; }
+  void apply(Button& button, bool active, uint32_t timestampUs);
+  InjectOutcome acceptPress(uint8_t index, uint32_t timestampUs);
+
+  GpioPort& gpio_;
+  Config config_;
+  size_t count_;
+  Button buttons_[MAX_BUTTONS];
+  SpscQueue<Edge, EDGE_QUEUE_CAPACITY> edges_;
+  SpscQueue<Press, PRESS_QUEUE_CAPACITY> presses_;
+  SpscQueue<Injection, INJECT_QUEUE_CAPACITY> injected_;
+  SpscQueue<InjectResult, INJECT_QUEUE_CAPACITY> injectResults_;
+  PressHook pressHook_ = nullptr;
+  void* pressHookContext_ = nullptr;
+  void (*edgeNotify_)(void*) = nullptr;
+  void* edgeNotifyContext_ = nullptr;
+  bool anyPressAccepted_ = false;
+  uint32_t lastPressUs_ = 0;
+  volatile uint32_t edgeCount_ = 0;
+  Stats stats_ = {};
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Drives the tacklebox latch from its own high-priority task, so the time from
+// "fire" to the coil energising no longer depends on what the loop task (web
+// server, sockets) is doing. fire() only records the request and notifies the
+// task; it is safe from any task or ISR. The task holds the coil for the pulse
+// and releases it itself.
+//
+// For the final Puzzle 3 press the game arms the expected button in advance, and
+// an input edge for that button fires the latch directly via onButtonEdge(),
+// before the press has been through the game logic at all. The input path only
+// offers a press when none is still waiting for the game ahead of it, and any
+// other button disarms, so the latch never opens on a press the game rejects.
+class LatchActuator {
+ public:
+  // Preempts the Arduino loop task (priority 1) on the same core.
+  static constexpr UBaseType_t TASK_PRIORITY = configMAX_PRIORITIES - 2;
+  static constexpr uint32_t TASK_STACK_SIZE = 2048;
+  static constexpr BaseType_t TASK_CORE = 1;
+  static constexpr uint8_t NO_BUTTON = 0;
+
+  enum class Source : uint8_t { None, FinalButton, Game };
+
+  struct Stats {
+    uint32_t fired;
+    uint32_t lastLatencyUs;  // Request timestamp to coil on.
+    uint32_t maxLatencyUs;
+    Source lastSource;
+    uint8_t armedButton;
+    bool active;  // Coil currently energised.
+  };
+
+  bool begin(uint8_t pin, uint32_t pulseMs);
+
+  // Arms (or, with NO_BUTTON, disarms) the button whose next press completes the
+  // mission.
+  void armFinalButton(uint8_t button) { armedButton_.store(button, std::memory_order_release); }
+
+  // Called from the input path with the edge's capture time. Returns true when
+  // the press was the armed final button and fired the latch; any other button
+  // disarms until the game has applied it and re-arms.
+  bool onButtonEdge(uint8_t button, uint32_t timestampUs);
+
+  // Requests a pulse unless one was already fired since the last rearm().
+  // requestedAtUs is the micros() timestamp latency is measured from.
+  bool fire(Source source, uint32_t requestedAtUs);
+
+  // Allows the next fire() (game reset).
+  void rearm();
+
+  bool fired() const { return fired_.load(std::memory_order_acquire); }
+  Stats stats() const;
+
+ private:
+  static void taskEntry(void* self);
+  void run();
+
+  uint8_t pin_ = 0;
+  uint32_t pulseMs_ = 0;
+  TaskHandle_t task_ = nullptr;
+  std::atomic<bool> fired_{false};
+  std::atomic<uint8_t> armedButton_{NO_BUTTON};
+  std::atomic<uint32_t> requestedAtUs_{0};
+  std::atomic<uint8_t> requestSource_{0};
+  std::atomic<bool> active_{false};
+  volatile uint32_t firedCount_ = 0;
+  volatile uint32_t lastLatencyUs_ = 0;
+  volatile uint32_t maxLatencyUs_ = 0;
+  volatile uint8_t lastSource_ = 0;
+};
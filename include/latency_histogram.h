@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Millisecond timings counted in fixed buckets, so a histogram costs the same
+// few dozen bytes however many samples it holds and two of them add up bucket
+// by bucket. Bucket i counts samples up to BOUNDS_MS[i]; the last bucket counts
+// everything slower. web/telemetry.js buckets its samples with the same bounds.
+struct LatencyHistogram {
+  static constexpr size_t BUCKETS = 9;
+  static constexpr uint16_t BOUNDS_MS[BUCKETS - 1] = {10, 25, 50, 100, 250, 500, 1000, 2500};
+
+  uint32_t counts[BUCKETS];
+
+  void add(const uint32_t* bucketCounts) {
+    for (size_t i = 0; i < BUCKETS; ++i) {
+      counts[i] += bucketCounts[i];
+    }
+  }
+
+  uint32_t total() const {
+    uint32_t sum = 0;
+    for (uint32_t count : counts) {
+      sum += count;
+    }
+    return sum;
+  }
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+enum class HttpMethod : uint8_t { Get, Post };
+
+// Compile-time route lookup. A route list (any struct with `method` and `path`
+// members) is indexed with a perfect hash: build() searches for a seed under which
+// every method+path pair lands in its own slot, so a lookup costs one hash, one
+// table read and one string compare, with no heap and no list walk.
+namespace route_table {
+
+constexpr uint32_t NO_SEED = UINT32_MAX;
+constexpr uint32_t MAX_SEED_SEARCH = 4096;
+
+constexpr size_t pathLength(const char* path) {
+  size_t length = 0;
+  while (path[length] != '\0') {
+    ++length;
+  }
+  return length;
+}
+
+// FNV-1a over the method byte and the path, finished with a shift-xor so the low
+// bits used for the slot depend on every input byte.
+constexpr uint32_t hashRoute(uint32_t seed, HttpMethod method, const char* path, size_t length) {
+  uint32_t hash = 2166136261u ^ seed;
+  hash = (hash ^ static_cast<uint8_t>(method)) * 16777619u;
+  for (size_t i = 0; i < length; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(path[i])) * 16777619u;
+  }
+  return hash ^ (hash >> 15);
+}
+
+template <size_t Slots>
+struct Index {
+  static_assert(Slots > 0 && Slots <= 256 && (Slots & (Slots - 1)) == 0, "Slots must be a power of two <= 256");
+
+  uint32_t seed;
+  uint8_t slots[Slots];  // Route index + 1; 0 marks an empty slot.
+};
+
+// Returns an index with seed NO_SEED when no seed separates the routes (for example
+// because two entries share a method and path); callers static_assert on it.
+template <size_t Slots, typename Route, size_t N>
+constexpr Index<Slots> build(const Route (&routes)[N]) {
+  static_assert(N < Slots, "Route table needs more slots than routes");
+  for (uint32_t seed = 0; seed < MAX_SEED_SEARCH; ++seed) {
+    Index<Slots> index{seed, {}};
+    bool collision = false;
+    for (size_t i = 0; i < N && !collision; ++i) {
+      size_t slot = hashRoute(seed, routes[i].method, routes[i].path, pathLength(routes[i].path)) & (Slots - 1);
+      collision = index.slots[slot] != 0;
+      index.slots[slot] = static_cast<uint8_t>(i + 1);
+    }
+    if (!collision) {
+      return index;
+    }
+  }
+  return Index<Slots>{NO_SEED, {}};
+}
+
+// Looks up a request path that need not be NUL-terminated.
+template <size_t Slots, typename Route, size_t N>
+const Route* find(const Index<Slots>& index, const Route (&routes)[N], HttpMethod method, const char* path,
+                  size_t length) {
+  uint8_t slot = index.slots[hashRoute(index.seed, method, path, length) & (Slots - 1)];
+  if (slot == 0) {
+    return nullptr;
+  }
+  const Route& route = routes[slot - 1];
+  if (route.method != method || strncmp(route.path, path, length) != 0 || route.path[length] != '\0') {
+    return nullptr;
+  }
+  return &route;
+}
+
+}  // namespace route_table
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Hashed timer wheel for timed game effects. Timers live in a fixed pool and are
+// hashed into Slots buckets by expiry tick; advance() walks one bucket per elapsed
+// tick, so the cost per tick is the timers due in that bucket plus the ones a
+// full wheel turn or more away (which only count down their rounds). Scheduling
+// and cancelling are O(1). Callbacks run inside advance(), on the caller's task.
+template <size_t Slots, size_t MaxTimers>
+class TimerWheel {
+  static_assert(Slots > 0 && (Slots & (Slots - 1)) == 0, "Slots must be a power of two");
+  static_assert(MaxTimers > 0 && MaxTimers < 255, "MaxTimers must fit the 8-bit timer index");
+
+ public:
+  using Callback = void (*)(void* context);
+  // Identifies one scheduling of a timer; stale ids are rejected by cancel().
+  using TimerId = uint32_t;
+  static constexpr TimerId NO_TIMER = 0;
+
+  explicit TimerWheel(uint32_t tickMs) : tickMs_(tickMs) {
+    for (uint8_t& head : heads_) {
+      head = NONE;
+    }
+    for (size_t i = 0; i < MaxTimers; ++i) {
+      timers_[i].next = static_cast<uint8_t>(i + 1 < MaxTimers ? i + 1 : NONE);
+    }
+    free_ = 0;
+  }
+
+  // Sets the wheel's notion of now without firing anything; call once, before the
+  // first schedule().
+  void start(uint32_t nowMs) {
+    lastTickMs_ = nowMs;
+  }
+
+  // Runs callback(context) delayMs after nowMs, rounded up to the tick. The
+  // expiry counts from nowMs rather than the last advance(), so a timer set while
+  // the wheel lags behind (a long loop pass, startup) does not fire early.
+  // Returns NO_TIMER when the pool is exhausted.
+  TimerId schedule(uint32_t nowMs, uint32_t delayMs, Callback callback, void* context) {
+    if (free_ == NONE) {
+      ++overflows_;
+      return NO_TIMER;
+    }
+    uint8_t index = free_;
+    Timer& timer = timers_[index];
+    free_ = timer.next;
+
+    uint32_t behindMs = static_cast<int32_t>(nowMs - lastTickMs_) > 0 ? nowMs - lastTickMs_ : 0;
+    uint32_t ticks = (behindMs + delayMs + tickMs_ - 1) / tickMs_;
+    if (ticks == 0) {
+      ticks = 1;
+    }
+    timer.callback = callback;
+    timer.context = context;
+    timer.rounds = (ticks - 1) / Slots;
+    timer.slot = static_cast<uint16_t>((currentSlot_ + ticks) & (Slots - 1));
+    timer.generation = static_cast<uint16_t>(timer.generation + 1);
+    if (timer.generation == 0) {
+      timer.generation = 1;
+    }
+    link(index);
+    ++active_;
+    return static_cast<TimerId>(timer.generation) << 8 | index;
+  }
+
+  // Cancels a pending timer; false if it already fired or was cancelled.
+  bool cancel(TimerId id) {
+    uint8_t index = static_cast<uint8_t>(id & 0xFF);
+    if (id == NO_TIMER || index >= MaxTimers) {
+      return false;
+    }
+    Timer& timer = timers_[index];
+    if (!timer.pending || timer.generation != static_cast<uint16_t>(id >> 8)) {
+      return false;
+    }
+    release(index);
+    return true;
+  }
+
+  // Fires everything due up to nowMs. Each tick first moves the bucket's due
+  // timers onto a separate list and only then runs them, so a callback may cancel
+  // or schedule any timer, including others due in the same tick.
+  void advance(uint32_t nowMs) {
+    while (nowMs - lastTickMs_ >= tickMs_) {
+      lastTickMs_ += tickMs_;
+      currentSlot_ = (currentSlot_ + 1) & (Slots - 1);
+      ++ticks_;
+      uint8_t index = heads_[currentSlot_];
+      while (index != NONE) {
+        Timer& timer = timers_[index];
+        uint8_t next = timer.next;
+        if (timer.rounds > 0) {
+          --timer.rounds;
+        } else {
+          unlink(index);
+          timer.slot = DUE_SLOT;
+          link(index);
+        }
+        index = next;
+      }
+      while (heads_[DUE_SLOT] != NONE) {
+        index = heads_[DUE_SLOT];
+        Callback callback = timers_[index].callback;
+        void* context = timers_[index].context;
+        release(index);
+        ++fired_;
+        callback(context);
+      }
+    }
+  }
+
+  size_t active() const { return active_; }
+  uint32_t fired() const { return fired_; }
+  uint32_t overflows() const { return overflows_; }
+  uint32_t ticks() const { return ticks_; }
+
+ private:
+  static constexpr uint8_t NONE = 0xFF;
+  static constexpr uint16_t DUE_SLOT = Slots;  // Extra bucket for timers firing this tick.
+
+  struct Timer {
+    Callback callback = nullptr;
+    void* context = nullptr;
+    uint32_t rounds = 0;
+    uint16_t slot = 0;
+    uint16_t generation = 0;
+    uint8_t next = NONE;
+    uint8_t prev = NONE;
+    bool pending = false;
+  };
+
+  void link(uint8_t index) {
+    Timer& timer = timers_[index];
+    timer.pending = true;
+    timer.prev = NONE;
+    timer.next = heads_[timer.slot];
+    if (timer.next != NONE) {
+      timers_[timer.next].prev = index;
+    }
+    heads_[timer.slot] = index;
+  }
+
+  void unlink(uint8_t index) {
+    Timer& timer = timers_[index];
+    if (timer.prev != NONE) {
+      timers_[timer.prev].next = timer.next;
+    } else {
+      heads_[timer.slot] = timer.next;
+    }
+    if (timer.next != NONE) {
+      timers_[timer.next].prev = timer.prev;
+    }
+  }
+
+  void release(uint8_t index) {
+    unlink(index);
+    Timer& timer = timers_[index];
+    timer.pending = false;
+    timer.next = free_;
+    free_ = index;
+    --active_;
+  }
+
+  uint32_t tickMs_;
+  uint32_t lastTickMs_ = 0;
+  size_t currentSlot_ = 0;
+  uint8_t heads_[Slots + 1];
+  Timer timers_[MaxTimers];
+  uint8_t free_;
+  size_t active_ = 0;
+  uint32_t fired_ = 0;
+  uint32_t overflows_ = 0;
+  uint32_t ticks_ = 0;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+#include "udp_input_protocol.h"
+
+// Hub end of the UDP button protocol. processPackets() reads pending datagrams,
+// drops duplicates with a per-node sliding window and hands each new press to
+// the press handler, which queues it with the wired buttons. Duplicates and bad
+// presses are acked straight back; a queued press is acked by completePress()
+// once the input engine has ruled on it. Node state lives in a fixed table; a
+// node not heard from for longest gives up its slot when it is full.
+class UdpInputServer {
+ public:
+  static constexpr size_t MAX_NODES = 16;
+  static constexpr size_t MAX_PACKETS_PER_CALL = 8;
+  static constexpr uint8_t REPLAY_WINDOW = 32;
+  // Presses queued and not yet acked; more are answered Busy.
+  static constexpr size_t MAX_PENDING = 16;
+
+  // Queues a new press, to be answered with completePress(tag, ...); false
+  // when it could not be queued and the node should send it again.
+  using PressHandler = bool (*)(uint8_t button, uint32_t receivedAtUs, uint8_t tag);
+
+  enum class Outcome : uint8_t { Applied, RateLimited, Busy };
+
+  struct Stats {
+    uint32_t packets;
+    uint32_t presses;
+    uint32_t duplicates;
+    uint32_t rejected;
+    uint32_t busy;         // Presses that could not be queued or applied.
+    uint32_t rateLimited;  // Presses dropped by the input rate cap.
+    uint32_t malformed;
+    uint32_t nodeEvictions;
+    uint32_t maxProcessUs;  // Receive to Applied ack sent, worst case.
+  };
+
+  bool begin(PressHandler handler);
+  void processPackets();
+  // Sends the ack for a queued press.
+  void completePress(uint8_t tag, Outcome outcome);
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct Node {
+    uint8_t id;  // 0 = free slot.
+    uint16_t session;
+    uint16_t highestSeq;
+    uint32_t window;  // Bit n set: highestSeq - n already applied.
+    unsigned long lastHeardMs;
+  };
+
+  struct Pending {
+    bool used;
+    IPAddress address;
+    uint16_t port;
+    uint32_t receivedAtUs;
+    udp_input::Packet packet;
+  };
+
+  Node& nodeFor(uint8_t id, uint16_t session);
+  bool markSeen(Node& node, uint16_t seq);
+  void forget(Node& node, uint16_t seq);
+  Pending* pendingFor(const udp_input::Packet& packet);
+  void sendAck(const IPAddress& address, uint16_t port, udp_input::Packet& packet, udp_input::AckStatus status);
+
+  WiFiUDP udp_;
+  PressHandler handler_ = nullptr;
+  Node nodes_[MAX_NODES] = {};
+  Pending pending_[MAX_PENDING] = {};
+  Stats stats_ = {};
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+// Wire format between wireless button/prop nodes and the hub's UDP input port.
+// Little-endian, one datagram per message; see scripts/udp_button_client.py for
+// a stand-in node. A node sends Press and retransmits it until the matching Ack
+// arrives; the hub applies each (node, session, seq) at most once and acks every
+// copy, so lost presses and lost acks are both recovered by the retransmit.
+// The first copy is acked once the hub's input engine has taken or dropped the
+// press, usually within a loop pass; copies that arrive meanwhile get no ack.
+namespace udp_input {
+
+constexpr uint16_t PORT = 4210;
+constexpr uint8_t MAGIC = 0xB7;
+constexpr uint8_t VERSION = 1;
+
+enum class MessageType : uint8_t { Press = 1, Ack = 2 };
+
+// Ack status; Press packets send Applied (0). Presses are ordered and rate-capped
+// with the wired buttons, so Applied means the game will see the press, not
+// whether it was the right one; the GM panel and displays show that.
+enum class AckStatus : uint8_t {
+  Applied = 0,      // First copy, queued for the game.
+  Duplicate = 1,    // Already answered (Applied or RateLimited); this copy was ignored.
+  Rejected = 2,     // Bad button id.
+  Busy = 3,         // Input queue full; not applied, retransmit.
+  RateLimited = 4,  // Too soon after the previous press of any button; dropped, do not retransmit.
+};
+
+struct __attribute__((packed)) Packet {
+  uint8_t magic;
+  uint8_t version;
+  uint8_t type;      // MessageType
+  uint8_t nodeId;    // 1-255, fixed per node.
+  uint16_t session;  // Random per node boot; a new session restarts seq.
+  uint16_t seq;      // Per press, wraps.
+  uint8_t button;    // Puzzle button 1-5.
+  uint8_t status;    // AckStatus (acks only).
+  uint8_t reserved[2];
+  uint32_t nodeTimeMs;  // Node clock at the press; echoed in the ack for RTT.
+};
+static_assert(sizeof(Packet) == 16, "udp_input::Packet is a wire format");
+
+}  // namespace udp_input
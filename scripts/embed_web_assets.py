@@ -0,0 +1,140 @@
+"""Embed the files under web/ into include/generated/web_assets.h.
+
+Runs as a PlatformIO pre-build script (see platformio.ini) and can also be run
+by hand: `python scripts/embed_web_assets.py`. Stylesheets and scripts are
+published under a content-hashed path (/assets/<hash>.<ext>) so browsers can
+cache them forever; editing a file changes its hash and therefore its URL.
+HTML page shells keep the routes main.cpp gives them and may reference the
+hashed assets with {{file.ext}} placeholders.
+
+Every asset is stored gzip-compressed, and only that way, so the firmware can
+write it straight from flash to the socket with Content-Encoding: gzip to every
+client; there is no uncompressed variant to negotiate.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+CONTENT_TYPES = {
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".html": "text/html",
+}
+
+# Page shells are routed by hand and substitute the hashed asset paths, so
+# they have to be processed after everything they can reference.
+SHELL_EXTENSIONS = (".html",)
+
+
+def project_dir():
+    try:
+        Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+        return env.subst("$PROJECT_DIR")  # noqa: F821
+    except NameError:
+        return os.path.dirname(os.path.dirname(os.path.abspath(sys.argv[0])))
+
+
+def symbol_for(filename):
+    return re.sub(r"[^A-Za-z0-9]", "_", filename).upper()
+
+
+def format_bytes(data):
+    lines = []
+    for offset in range(0, len(data), 16):
+        chunk = data[offset:offset + 16]
+        lines.append("    " + ", ".join("0x%02x" % b for b in chunk) + ",")
+    return "\n".join(lines)
+
+
+def render_header(assets):
+    out = [
+        "// Generated by scripts/embed_web_assets.py from web/. Do not edit.",
+        "#pragma once",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "namespace web_assets {",
+        "",
+        "struct Asset {",
+        "  const char* path;  // Hashed /assets/ URL, or nullptr for page shells routed by hand.",
+        "  const char* contentType;",
+        "  const char* contentEncoding;",
+        "  const char* etag;",
+        "  const uint8_t* data;",
+        "  size_t length;",
+        "};",
+        "",
+    ]
+    for asset in assets:
+        out.append("constexpr uint8_t %s_DATA[] PROGMEM = {" % asset["symbol"])
+        out.append(format_bytes(asset["data"]))
+        out.append("};")
+        path = '"%s"' % asset["path"] if asset["path"] else "nullptr"
+        out.append('constexpr Asset %s = {%s, "%s", "gzip", "\\"%s\\"", %s_DATA, sizeof(%s_DATA)};' % (
+            asset["symbol"], path, asset["type"], asset["digest"], asset["symbol"], asset["symbol"]))
+        out.append("")
+    out.append("constexpr Asset ALL[] = {%s};" % ", ".join(a["symbol"] for a in assets))
+    out.append("")
+    out.append("}  // namespace web_assets")
+    out.append("")
+    return "\n".join(out)
+
+
+def make_asset(filename, data, routed):
+    ext = os.path.splitext(filename)[1]
+    digest = hashlib.sha256(data).hexdigest()[:10]
+    return {
+        "symbol": symbol_for(filename),
+        "path": "/assets/%s%s" % (digest, ext) if routed else None,
+        "type": CONTENT_TYPES[ext],
+        "digest": digest,
+        # mtime=0 keeps the output byte-identical between builds.
+        "data": gzip.compress(data, compresslevel=9, mtime=0),
+    }
+
+
+def substitute_paths(data, assets, filename):
+    def replace(match):
+        name = match.group(1).decode()
+        if name not in assets:
+            raise SystemExit("[web_assets] %s references unknown asset %s" % (filename, name))
+        return assets[name]["path"].encode()
+    return re.sub(rb"\{\{([A-Za-z0-9_.-]+)\}\}", replace, data)
+
+
+def collect_assets(web_dir):
+    sources = {}
+    for filename in sorted(os.listdir(web_dir)):
+        if os.path.splitext(filename)[1] in CONTENT_TYPES:
+            with open(os.path.join(web_dir, filename), "rb") as handle:
+                sources[filename] = handle.read()
+
+    routed = {}
+    for filename, data in sources.items():
+        if not filename.endswith(SHELL_EXTENSIONS):
+            routed[filename] = make_asset(filename, data, True)
+    shells = []
+    for filename, data in sources.items():
+        if filename.endswith(SHELL_EXTENSIONS):
+            shells.append(make_asset(filename, substitute_paths(data, routed, filename), False))
+    return list(routed.values()) + shells
+
+
+def main():
+    root = project_dir()
+    header = render_header(collect_assets(os.path.join(root, "web")))
+    out_path = os.path.join(root, "include", "generated", "web_assets.h")
+    os.makedirs(os.path.dirname(out_path), exist_ok=True)
+    if os.path.exists(out_path):
+        with open(out_path, "r") as handle:
+            if handle.read() == header:
+                return
+    with open(out_path, "w") as handle:
+        handle.write(header)
+    print("[web_assets] Regenerated %s" % os.path.relpath(out_path, root))
+
+
+main()
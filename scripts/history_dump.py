@@ -0,0 +1,70 @@
+"""Decodes a game history session from the hub's /history endpoint.
+
+Prints one line per recorded event, as CSV, for post-show analysis:
+
+    python scripts/history_dump.py                      # list sessions on the hub
+    python scripts/history_dump.py --session 12         # fetch and decode session 12
+    python scripts/history_dump.py --file session-12.bin
+
+The file layout is HistoryLog::FileHeader (include/history_log.h) followed by
+GameEvent records (include/event_log.h). Timestamps are hub millis() and
+restart at every boot; a "restored" event marks a reboot mid-session.
+"""
+
+import argparse
+import json
+import struct
+import sys
+import urllib.request
+
+HEADER = struct.Struct("<4sBBHII")
+EVENT = struct.Struct("<IIBBBB")
+
+EVENT_NAMES = {
+    1: "transition",
+    2: "button",
+    3: "conduits",
+    4: "latch",
+    5: "reset",
+    6: "remote",
+    7: "clock",
+    8: "restored",
+}
+
+
+def decode(data):
+    if len(data) < HEADER.size:
+        raise ValueError("file shorter than its header")
+    magic, version, record_size, _, session, boot_id = HEADER.unpack_from(data)
+    if magic != b"HIST" or version != 1 or record_size != EVENT.size:
+        raise ValueError("not a version 1 history file")
+    print(f"# session {session}, boot {boot_id:08x}")
+    print("seq,ms,event,a,b,c")
+    for offset in range(HEADER.size, len(data) - EVENT.size + 1, EVENT.size):
+        seq, ms, kind, a, b, c = EVENT.unpack_from(data, offset)
+        print(f"{seq},{ms},{EVENT_NAMES.get(kind, kind)},{a},{b},{c}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="192.168.4.1")
+    parser.add_argument("--session", type=int, help="session number to fetch")
+    parser.add_argument("--file", help="decode a previously downloaded session file instead")
+    args = parser.parse_args()
+
+    if args.file:
+        with open(args.file, "rb") as f:
+            decode(f.read())
+        return 0
+    url = f"http://{args.host}/history"
+    if args.session is None:
+        with urllib.request.urlopen(url) as response:
+            print(json.dumps(json.load(response), indent=2))
+        return 0
+    with urllib.request.urlopen(f"{url}?session={args.session}") as response:
+        decode(response.read())
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,87 @@
+"""Stand-in wireless button node for the hub's UDP input port.
+
+Sends each press as a udp_input::Packet (include/udp_input_protocol.h) and
+retransmits it until the hub acks, the same way a real node does, then prints
+the ack status and the round trip. A "busy" ack means the hub's input queue was
+full and the press is sent again; "rate-limited" means the hub dropped the press
+for coming too soon after the previous one, as it would a wired press:
+
+    python scripts/udp_button_client.py 4 1 5 1 3
+    python scripts/udp_button_client.py --host 192.168.4.1 --node 7 --loss 0.3 4 1 5
+
+--loss drops that fraction of outgoing packets on purpose to exercise recovery.
+"""
+
+import argparse
+import random
+import socket
+import struct
+import sys
+import time
+
+PORT = 4210
+MAGIC = 0xB7
+VERSION = 1
+TYPE_PRESS = 1
+TYPE_ACK = 2
+PACKET = struct.Struct("<BBBBHHBBBBI")
+
+ACK_STATUS = {0: "applied", 1: "duplicate", 2: "rejected", 3: "busy", 4: "rate-limited"}
+
+
+def send_press(sock, address, node, session, seq, button, retry_ms, max_tries, loss):
+    now_ms = int(time.monotonic() * 1000) & 0xFFFFFFFF
+    packet = PACKET.pack(MAGIC, VERSION, TYPE_PRESS, node, session, seq, button, 0, 0, 0, now_ms)
+    started = time.monotonic()
+    for attempt in range(1, max_tries + 1):
+        if random.random() >= loss:
+            sock.sendto(packet, address)
+        deadline = time.monotonic() + retry_ms / 1000.0
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                break
+            sock.settimeout(remaining)
+            try:
+                data, _ = sock.recvfrom(64)
+            except socket.timeout:
+                break
+            if len(data) != PACKET.size:
+                continue
+            fields = PACKET.unpack(data)
+            if fields[2] != TYPE_ACK or fields[3] != node or fields[4] != session or fields[5] != seq:
+                continue  # Late ack for an earlier press.
+            status = ACK_STATUS.get(fields[7], "?")
+            if status == "busy":
+                time.sleep(max(0.0, deadline - time.monotonic()))
+                break  # Not applied; retransmit after the retry interval.
+            rtt_ms = (time.monotonic() - started) * 1000.0
+            return attempt, status, rtt_ms
+    return max_tries, "lost", (time.monotonic() - started) * 1000.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("buttons", nargs="+", type=int, help="buttons to press, 1-5")
+    parser.add_argument("--host", default="192.168.4.1")
+    parser.add_argument("--node", type=int, default=1, help="node id, 1-255")
+    parser.add_argument("--interval-ms", type=int, default=250, help="delay between presses")
+    parser.add_argument("--retry-ms", type=int, default=30, help="retransmit after this long without an ack")
+    parser.add_argument("--tries", type=int, default=10)
+    parser.add_argument("--loss", type=float, default=0.0, help="fraction of sends to drop on purpose")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    session = random.randrange(0x10000)
+    lost = 0
+    for seq, button in enumerate(args.buttons):
+        tries, status, rtt_ms = send_press(sock, (args.host, PORT), args.node, session, seq & 0xFFFF,
+                                                   button, args.retry_ms, args.tries, args.loss)
+        lost += status == "lost"
+        print(f"button {button}: {status} after {tries} send(s), {rtt_ms:.1f} ms")
+        time.sleep(args.interval_ms / 1000.0)
+    return 1 if lost else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
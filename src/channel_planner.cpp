@@ -0,0 +1,68 @@
+#include "channel_planner.h"
+
+namespace {
+
+// Share of a network's weight felt 0, 1, 2, 3 and 4 channels away.
+constexpr uint8_t OVERLAP_WEIGHT[] = {10, 7, 4, 2, 1};
+constexpr int RSSI_FLOOR_DBM = -100;
+constexpr int RSSI_WEIGHT_MAX = 80;
+
+// -95 dBm barely counts; -20 dBm next door counts sixteen times as much.
+uint32_t rssiWeight(int8_t rssi) {
+  int weight = rssi - RSSI_FLOOR_DBM;
+  if (weight < 1) {
+    return 1;
+  }
+  return static_cast<uint32_t>(weight > RSSI_WEIGHT_MAX ? RSSI_WEIGHT_MAX : weight);
+}
+
+bool isNonOverlapping(uint8_t channel) {
+  return channel == 1 || channel == 6 || channel == 11;
+}
+
+}  // namespace
+
+uint32_t ChannelPlanner::score(const ScannedNetwork* networks, size_t count, uint8_t channel) {
+  uint32_t total = 0;
+  for (size_t i = 0; i < count; ++i) {
+    int distance = networks[i].channel > channel ? networks[i].channel - channel : channel - networks[i].channel;
+    if (distance < static_cast<int>(sizeof(OVERLAP_WEIGHT))) {
+      total += rssiWeight(networks[i].rssi) * OVERLAP_WEIGHT[distance];
+    }
+  }
+  return total;
+}
+
+uint8_t ChannelPlanner::best(const uint32_t* scores, uint8_t fallbackChannel) {
+  uint8_t chosen = 0;
+  for (uint8_t channel = MIN_CHANNEL; channel <= MAX_CHANNEL; ++channel) {
+    if (chosen == 0 || scores[channel] < scores[chosen]) {
+      chosen = channel;
+      continue;
+    }
+    if (scores[channel] > scores[chosen]) {
+      continue;
+    }
+    bool preferred = isNonOverlapping(channel) && !isNonOverlapping(chosen);
+    bool sameClass = isNonOverlapping(channel) == isNonOverlapping(chosen);
+    if (preferred || (sameClass && channel == fallbackChannel)) {
+      chosen = channel;
+    }
+  }
+  return chosen;
+}
+
+uint8_t ChannelPlanner::plan(uint8_t fallbackChannel) {
+  ScannedNetwork networks[MAX_NETWORKS];
+  int found = scanner_.scan(networks, MAX_NETWORKS);
+  scanned_ = found >= 0;
+  if (!scanned_) {
+    networkCount_ = 0;
+    return fallbackChannel;
+  }
+  networkCount_ = static_cast<size_t>(found);
+  for (uint8_t channel = MIN_CHANNEL; channel <= MAX_CHANNEL; ++channel) {
+    scores_[channel] = score(networks, networkCount_, channel);
+  }
+  return best(scores_, fallbackChannel);
+}
@@ -0,0 +1,101 @@
+#include "client_registry.h"
+
+#include <string.h>
+
+ClientRegistry::Client& ClientRegistry::lookup(uint32_t ip, const char* id, uint32_t nowMs) {
+  Client* sameIp = nullptr;
+  for (Client& client : clients_) {
+    if (client.ip == 0) {
+      continue;
+    }
+    if (id[0] != '\0' && strcmp(client.id, id) == 0) {
+      client.ip = ip;  // The same script, back under a new DHCP lease.
+      return client;
+    }
+    if (client.ip == ip && (sameIp == nullptr || static_cast<int32_t>(client.lastSeenMs - sameIp->lastSeenMs) > 0)) {
+      sameIp = &client;
+    }
+  }
+  if (sameIp != nullptr && (id[0] == '\0' || sameIp->id[0] == '\0')) {
+    // Either an anonymous request from a known address, or the first request
+    // with an id from an address that so far only loaded pages.
+    if (sameIp->id[0] == '\0') {
+      strncpy(sameIp->id, id, ID_LENGTH);
+    }
+    return *sameIp;
+  }
+  return claim(ip, id, nowMs);
+}
+
+ClientRegistry::Client& ClientRegistry::claim(uint32_t ip, const char* id, uint32_t nowMs) {
+  Client* slot = &clients_[0];
+  for (Client& client : clients_) {
+    if (client.ip == 0) {
+      slot = &client;
+      break;
+    }
+    if (static_cast<int32_t>(client.lastSeenMs - slot->lastSeenMs) < 0) {
+      slot = &client;
+    }
+  }
+  if (slot->ip != 0) {
+    ++evictions_;
+  }
+  memset(slot, 0, sizeof(*slot));
+  slot->ip = ip;
+  strncpy(slot->id, id, ID_LENGTH);
+  slot->firstSeenMs = nowMs;
+  slot->lastSeenMs = nowMs;
+  return *slot;
+}
+
+void ClientRegistry::recordRequest(Client& client, bool poll, size_t bytes, int status, uint32_t nowMs) {
+  client.lastSeenMs = nowMs;
+  ++client.requests;
+  client.bytes += static_cast<uint32_t>(bytes);
+  if (status >= 400) {
+    ++client.errors;
+  }
+  if (!poll) {
+    return;
+  }
+  if (client.polls > 0) {
+    uint32_t interval = nowMs - client.lastPollMs;
+    client.pollIntervalMs = client.polls == 1 ? interval : (client.pollIntervalMs * 3 + interval) / 4;
+  }
+  ++client.polls;
+  client.lastPollMs = nowMs;
+}
+
+void ClientRegistry::recordRenderLatency(Client& client, uint32_t renderMs) {
+  client.renderMs = static_cast<uint16_t>(renderMs > UINT16_MAX ? UINT16_MAX : renderMs);
+  if (client.renderMs > client.maxRenderMs) {
+    client.maxRenderMs = client.renderMs;
+  }
+}
+
+namespace {
+
+void addTelemetry(ClientRegistry::Telemetry& into, const ClientRegistry::Telemetry& report) {
+  into.fetchMs.add(report.fetchMs.counts);
+  into.renderMs.add(report.renderMs.counts);
+  into.droppedFrames += report.droppedFrames;
+  into.errors += report.errors;
+  ++into.reports;
+}
+
+}  // namespace
+
+void ClientRegistry::recordTelemetry(Client& client, const Telemetry& report) {
+  addTelemetry(client.telemetry, report);
+  addTelemetry(totals_, report);
+}
+
+const ClientRegistry::Client* ClientRegistry::findById(const char* id) const {
+  for (const Client& client : clients_) {
+    if (client.ip != 0 && strcmp(client.id, id) == 0) {
+      return &client;
+    }
+  }
+  return nullptr;
+}
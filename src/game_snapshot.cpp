@@ -0,0 +1,111 @@
+#include "game_snapshot.h"
+
+#include <Arduino.h>
+#include <string.h>
+
+namespace {
+
+constexpr uint8_t RECORD_MAGIC = 0xC5;
+constexpr uint8_t FLAG_CONDUITS_VERIFIED = 0x01;
+constexpr uint8_t FLAG_LATCH_TRIGGERED = 0x02;
+constexpr uint8_t FLAG_CLOCK_RUNNING = 0x04;
+constexpr char NVS_NAMESPACE[] = "hub";
+constexpr char NVS_KEY[] = "snapshot";
+
+// Survives every reset that keeps the chip powered; garbage after power-on,
+// which the magic and checksum reject.
+RTC_NOINIT_ATTR uint8_t rtcRecord[GameSnapshotStore::RECORD_SIZE];
+
+uint8_t crc8(const uint8_t* data, size_t length) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < length; ++i) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = static_cast<uint8_t>(crc & 0x80 ? crc << 1 ^ 0x07 : crc << 1);
+    }
+  }
+  return crc;
+}
+
+}  // namespace
+
+bool GameSnapshotStore::begin() {
+  ready_ = prefs_.begin(NVS_NAMESPACE, false);
+  return ready_;
+}
+
+bool GameSnapshotStore::restore(GameSnapshot& snapshot) {
+  if (decode(rtcRecord, snapshot)) {
+    stats_.restoredFrom = Source::Rtc;
+    return true;
+  }
+  uint8_t record[RECORD_SIZE];
+  if (ready_ && prefs_.getBytes(NVS_KEY, record, sizeof(record)) == sizeof(record) && decode(record, snapshot)) {
+    stats_.restoredFrom = Source::Nvs;
+    return true;
+  }
+  stats_.restoredFrom = Source::None;
+  return false;
+}
+
+void GameSnapshotStore::save(const GameSnapshot& snapshot, uint32_t nowMs) {
+  if (hasLast_ && snapshot.sameGame(last_) && snapshot.clockSeconds == last_.clockSeconds) {
+    return;
+  }
+  encode(snapshot, rtcRecord);
+  ++stats_.saves;
+  if (!hasLast_ || !snapshot.sameGame(last_)) {
+    if (!gamePending_) {
+      gamePending_ = true;
+      gameChangedMs_ = nowMs;
+    }
+  } else {
+    clockPending_ = true;
+  }
+  last_ = snapshot;
+  hasLast_ = true;
+}
+
+void GameSnapshotStore::flush(uint32_t nowMs) {
+  bool due = gamePending_ ? nowMs - gameChangedMs_ >= COALESCE_MS
+                          : clockPending_ && nowMs - lastNvsWriteMs_ >= CLOCK_REFRESH_MS;
+  if (!due || !ready_) {
+    return;
+  }
+  gamePending_ = false;
+  clockPending_ = false;
+  lastNvsWriteMs_ = nowMs;
+  if (prefs_.putBytes(NVS_KEY, rtcRecord, RECORD_SIZE) == RECORD_SIZE) {
+    ++stats_.nvsWrites;
+  } else {
+    ++stats_.nvsErrors;
+  }
+}
+
+// Layout: magic, format version, state, flags, next sequence index, clock
+// seconds (little-endian), CRC-8 of the bytes before it.
+void GameSnapshotStore::encode(const GameSnapshot& snapshot, uint8_t* record) {
+  record[0] = RECORD_MAGIC;
+  record[1] = FORMAT_VERSION;
+  record[2] = snapshot.state;
+  record[3] = static_cast<uint8_t>((snapshot.conduitsVerified ? FLAG_CONDUITS_VERIFIED : 0) |
+                                   (snapshot.latchTriggered ? FLAG_LATCH_TRIGGERED : 0) |
+                                   (snapshot.clockRunning ? FLAG_CLOCK_RUNNING : 0));
+  record[4] = snapshot.nextSequenceIndex;
+  record[5] = static_cast<uint8_t>(snapshot.clockSeconds);
+  record[6] = static_cast<uint8_t>(snapshot.clockSeconds >> 8);
+  record[7] = crc8(record, RECORD_SIZE - 1);
+}
+
+bool GameSnapshotStore::decode(const uint8_t* record, GameSnapshot& snapshot) {
+  if (record[0] != RECORD_MAGIC || record[1] != FORMAT_VERSION || record[7] != crc8(record, RECORD_SIZE - 1)) {
+    return false;
+  }
+  snapshot.state = record[2];
+  snapshot.conduitsVerified = record[3] & FLAG_CONDUITS_VERIFIED;
+  snapshot.latchTriggered = record[3] & FLAG_LATCH_TRIGGERED;
+  snapshot.clockRunning = record[3] & FLAG_CLOCK_RUNNING;
+  snapshot.nextSequenceIndex = record[4];
+  snapshot.clockSeconds = static_cast<uint16_t>(record[5] | record[6] << 8);
+  return true;
+}
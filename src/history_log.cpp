@@ -0,0 +1,146 @@
+#include "history_log.h"
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+constexpr char HISTORY_DIR[] = "/history";
+
+// Session number of a "<n>.bin" entry, 0 for anything else. Directory entries
+// are named with or without the directory depending on the core version.
+uint32_t sessionFromName(const char* name) {
+  const char* base = strrchr(name, '/');
+  base = base ? base + 1 : name;
+  char* end = nullptr;
+  unsigned long session = strtoul(base, &end, 10);
+  return end != base && strcmp(end, ".bin") == 0 ? static_cast<uint32_t>(session) : 0;
+}
+
+}  // namespace
+
+bool HistoryLog::begin(uint32_t bootId, bool continueLastSession) {
+  bootId_ = bootId;
+  if (!LittleFS.begin(true)) {
+    return false;
+  }
+  if (!LittleFS.exists(HISTORY_DIR) && !LittleFS.mkdir(HISTORY_DIR)) {
+    return false;
+  }
+  File dir = LittleFS.open(HISTORY_DIR);
+  for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+    uint32_t session = sessionFromName(entry.name());
+    if (session > session_) {
+      session_ = session;
+    }
+  }
+  dir.close();
+  ready_ = true;
+  if (continueLastSession && session_ > 0 && openFile(false)) {
+    return true;
+  }
+  return startSession();
+}
+
+bool HistoryLog::startSession() {
+  if (!ready_) {
+    return false;
+  }
+  flush();
+  if (file_) {
+    file_.close();
+  }
+  ++session_;
+  if (session_ > MAX_SESSIONS) {
+    char path[32];
+    sessionPath(session_ - MAX_SESSIONS, path, sizeof(path));
+    LittleFS.remove(path);
+  }
+  return openFile(true);
+}
+
+bool HistoryLog::openFile(bool create) {
+  char path[32];
+  sessionPath(session_, path, sizeof(path));
+  if (!create && !LittleFS.exists(path)) {
+    return false;
+  }
+  file_ = LittleFS.open(path, create ? FILE_WRITE : FILE_APPEND);
+  if (!file_) {
+    ++stats_.writeErrors;
+    return false;
+  }
+  if (create) {
+    FileHeader header = {{'H', 'I', 'S', 'T'}, FORMAT_VERSION, sizeof(GameEvent), 0, session_, bootId_};
+    if (file_.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) != sizeof(header)) {
+      ++stats_.writeErrors;
+    }
+    file_.flush();
+  }
+  return true;
+}
+
+bool HistoryLog::add(const GameEvent& event, uint32_t nowMs) {
+  if (full()) {
+    return false;
+  }
+  if (count_ == 0) {
+    firstBufferedMs_ = nowMs;
+  }
+  page_[count_++] = event;
+  ++stats_.records;
+  return true;
+}
+
+bool HistoryLog::flushDue(uint32_t nowMs) const {
+  return full() || (count_ > 0 && nowMs - firstBufferedMs_ >= FLUSH_AFTER_MS);
+}
+
+bool HistoryLog::flush() {
+  if (count_ == 0) {
+    return true;
+  }
+  size_t bytes = count_ * sizeof(GameEvent);
+  bool wasFull = full();
+  count_ = 0;
+  if (!file_) {
+    ++stats_.writeErrors;
+    return false;
+  }
+  uint32_t start = micros();
+  bool written = file_.write(reinterpret_cast<const uint8_t*>(page_), bytes) == bytes;
+  file_.flush();
+  uint32_t elapsed = micros() - start;
+  if (elapsed > stats_.maxWriteUs) {
+    stats_.maxWriteUs = elapsed;
+  }
+  if (!written) {
+    ++stats_.writeErrors;
+    return false;
+  }
+  if (wasFull) {
+    ++stats_.pageWrites;
+  } else {
+    ++stats_.partialWrites;
+  }
+  return true;
+}
+
+bool HistoryLog::openSession(uint32_t session, File& file) const {
+  if (!ready_ || session == 0) {
+    return false;
+  }
+  char path[32];
+  sessionPath(session, path, sizeof(path));
+  if (!LittleFS.exists(path)) {
+    return false;
+  }
+  file = LittleFS.open(path, FILE_READ);
+  return static_cast<bool>(file);
+}
+
+void HistoryLog::sessionPath(uint32_t session, char* out, size_t size) {
+  snprintf(out, size, "%s/%lu.bin", HISTORY_DIR, static_cast<unsigned long>(session));
+}
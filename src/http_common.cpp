@@ -0,0 +1,80 @@
+#include "http_common.h"
+
+#include <stdio.h>
+
+const char* httpStatusReason(int status) {
+  switch (status) {
+    case 200:
+      return "OK";
+    case 204:
+      return "No Content";
+    case 304:
+      return "Not Modified";
+    case 400:
+      return "Bad Request";
+    case 404:
+      return "Not Found";
+    case 405:
+      return "Method Not Allowed";
+    case 413:
+      return "Payload Too Large";
+    case 431:
+      return "Request Header Fields Too Large";
+    case 500:
+      return "Internal Server Error";
+    case 503:
+      return "Service Unavailable";
+    default:
+      return "Unknown";
+  }
+}
+
+size_t formatResponseHead(char* out, size_t size, int status, const char* contentType, size_t contentLength,
+                          const char* extraHeaders, bool keepAlive) {
+  int length;
+  if (status == 204 || status == 304) {
+    length = snprintf(out, size, "HTTP/1.1 %d %s\r\n%sConnection: %s\r\n\r\n", status, httpStatusReason(status),
+                      extraHeaders, keepAlive ? "keep-alive" : "close");
+  } else {
+    length = snprintf(out, size, "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %u\r\n%sConnection: %s\r\n\r\n",
+                      status, httpStatusReason(status), contentType, static_cast<unsigned>(contentLength),
+                      extraHeaders, keepAlive ? "keep-alive" : "close");
+  }
+  if (length < 0 || static_cast<size_t>(length) >= size) {
+    return 0;
+  }
+  return static_cast<size_t>(length);
+}
+
+namespace {
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+}  // namespace
+
+size_t urlDecodeInPlace(char* text, size_t length) {
+  size_t out = 0;
+  for (size_t in = 0; in < length; ++in) {
+    char c = text[in];
+    if (c == '+') {
+      c = ' ';
+    } else if (c == '%' && in + 2 < length && hexValue(text[in + 1]) >= 0 && hexValue(text[in + 2]) >= 0) {
+      c = static_cast<char>(hexValue(text[in + 1]) * 16 + hexValue(text[in + 2]));
+      in += 2;
+    }
+    text[out++] = c;
+  }
+  text[out] = '\0';
+  return out;
+}
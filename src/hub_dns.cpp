@@ -0,0 +1,141 @@
+#include "hub_dns.h"
+
+#include <string.h>
+#include <strings.h>
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 12;
+constexpr uint16_t TYPE_A = 1;
+constexpr uint16_t CLASS_IN = 1;
+constexpr uint8_t FLAG_QR = 0x80;
+constexpr uint8_t FLAG_AA = 0x04;
+constexpr uint8_t FLAG_RD = 0x01;
+constexpr uint8_t FLAG_RA = 0x80;
+constexpr uint8_t OPCODE_MASK = 0x78;
+constexpr uint8_t RCODE_FORMERR = 1;
+constexpr uint8_t RCODE_NXDOMAIN = 3;
+constexpr uint8_t RCODE_NOTIMP = 4;
+
+uint16_t readU16(const uint8_t* data) {
+  return static_cast<uint16_t>(data[0] << 8 | data[1]);
+}
+
+uint8_t* writeU16(uint8_t* out, uint16_t value) {
+  out[0] = static_cast<uint8_t>(value >> 8);
+  out[1] = static_cast<uint8_t>(value);
+  return out + 2;
+}
+
+}  // namespace
+
+bool HubDnsResponder::begin(IPAddress address, const char* const* names, size_t nameCount) {
+  for (int i = 0; i < 4; ++i) {
+    address_[i] = address[i];
+  }
+  names_ = names;
+  nameCount_ = nameCount;
+  return udp_.begin(PORT) == 1;
+}
+
+bool HubDnsResponder::isKnownName(const char* name) const {
+  for (size_t i = 0; i < nameCount_; ++i) {
+    if (strcasecmp(name, names_[i]) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void HubDnsResponder::processQueries() {
+  for (size_t i = 0; i < MAX_QUERIES_PER_CALL; ++i) {
+    int size = udp_.parsePacket();
+    if (size <= 0) {
+      return;
+    }
+    ++stats_.queries;
+    int length = udp_.read(packet_, sizeof(packet_));
+    size_t replyLength = length > 0 ? answer(static_cast<size_t>(length)) : 0;
+    if (replyLength == 0) {
+      ++stats_.malformed;
+      continue;
+    }
+    udp_.beginPacket(udp_.remoteIP(), udp_.remotePort());
+    udp_.write(packet_, replyLength);
+    udp_.endPacket();
+  }
+}
+
+// Rewrites the query in packet_ into its reply and returns the reply length, or
+// 0 when the packet is too broken to answer at all.
+size_t HubDnsResponder::answer(size_t length) {
+  if (length < HEADER_SIZE || (packet_[2] & FLAG_QR) != 0) {
+    return 0;
+  }
+  uint8_t* flags = packet_ + 2;
+  bool recursionDesired = (flags[0] & FLAG_RD) != 0;
+  uint8_t opcode = flags[0] & OPCODE_MASK;
+  flags[0] = static_cast<uint8_t>(FLAG_QR | FLAG_AA | opcode | (recursionDesired ? FLAG_RD : 0));
+  flags[1] = FLAG_RA;
+  // Answer, authority and additional counts are rebuilt below; EDNS records are dropped.
+  memset(packet_ + 6, 0, 6);
+
+  if (opcode != 0 || readU16(packet_ + 4) != 1) {
+    flags[1] |= opcode != 0 ? RCODE_NOTIMP : RCODE_FORMERR;
+    writeU16(packet_ + 4, 0);
+    return HEADER_SIZE;
+  }
+
+  // Question name: length-prefixed labels, flattened into a dotted string.
+  char name[128];
+  size_t nameLength = 0;
+  size_t offset = HEADER_SIZE;
+  while (offset < length && packet_[offset] != 0) {
+    uint8_t labelLength = packet_[offset];
+    if ((labelLength & 0xC0) != 0 || offset + 1 + labelLength > length ||
+        nameLength + labelLength + 1 >= sizeof(name)) {
+      flags[1] |= RCODE_FORMERR;
+      writeU16(packet_ + 4, 0);
+      return HEADER_SIZE;
+    }
+    if (nameLength > 0) {
+      name[nameLength++] = '.';
+    }
+    memcpy(name + nameLength, packet_ + offset + 1, labelLength);
+    nameLength += labelLength;
+    offset += 1 + labelLength;
+  }
+  name[nameLength] = '\0';
+  size_t questionEnd = offset + 5;  // Root label, QTYPE, QCLASS.
+  if (questionEnd > length) {
+    flags[1] |= RCODE_FORMERR;
+    writeU16(packet_ + 4, 0);
+    return HEADER_SIZE;
+  }
+  uint16_t type = readU16(packet_ + offset + 1);
+  uint16_t queryClass = readU16(packet_ + offset + 3);
+
+  if (!isKnownName(name)) {
+    ++stats_.nxDomain;
+    flags[1] |= RCODE_NXDOMAIN;
+    return questionEnd;
+  }
+  if (type != TYPE_A || queryClass != CLASS_IN) {
+    // AAAA and friends: the name exists but has no such record, so clients stop
+    // waiting for IPv6 and use the A answer.
+    ++stats_.noData;
+    return questionEnd;
+  }
+
+  ++stats_.answered;
+  uint8_t* out = packet_ + questionEnd;
+  out = writeU16(out, 0xC000 | HEADER_SIZE);  // Name: pointer to the question.
+  out = writeU16(out, TYPE_A);
+  out = writeU16(out, CLASS_IN);
+  out = writeU16(out, static_cast<uint16_t>(ANSWER_TTL_S >> 16));
+  out = writeU16(out, static_cast<uint16_t>(ANSWER_TTL_S));
+  out = writeU16(out, 4);
+  memcpy(out, address_, 4);
+  writeU16(packet_ + 6, 1);
+  return questionEnd + 16;
+}
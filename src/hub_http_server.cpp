@@ -0,0 +1,586 @@
+#include "hub_http_server.h"
+
+#include <Arduino.h>
+#include <errno.h>
+#include <lwip/sockets.h>
+
+namespace {
+
+bool wouldBlock() {
+  return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+void setNonBlocking(int fd) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+bool headerNameIs(const char* name, size_t length, const char* expected) {
+  return strlen(expected) == length && strncasecmp(name, expected, length) == 0;
+}
+
+const char* findHeaderEnd(const char* data, size_t length) {
+  for (size_t i = 3; i < length; ++i) {
+    if (data[i] == '\n' && data[i - 1] == '\r' && data[i - 2] == '\n' && data[i - 3] == '\r') {
+      return data + i + 1;
+    }
+  }
+  return nullptr;
+}
+
+// Finds the Content-Length among the headers of the request at data, whose
+// headers end at headerEnd; 0 when there is none. Returns false for a value that
+// is not plain digits (strtoul would otherwise take signs, skip spaces and wrap).
+bool findContentLength(const char* data, const char* headerEnd, size_t& contentLength) {
+  contentLength = 0;
+  const char* line = strstr(data, "\r\n") + 2;
+  while (line < headerEnd - 2) {
+    const char* end = strstr(line, "\r\n");
+    const char* colon = static_cast<const char*>(memchr(line, ':', end - line));
+    if (colon != nullptr && headerNameIs(line, colon - line, "Content-Length")) {
+      const char* value = colon + 1;
+      while (value < end && *value == ' ') {
+        ++value;
+      }
+      char* digitsEnd = nullptr;
+      errno = 0;
+      contentLength = strtoul(value, &digitsEnd, 10);
+      while (digitsEnd < end && *digitsEnd == ' ') {
+        ++digitsEnd;
+      }
+      return value != end && *value >= '0' && *value <= '9' && digitsEnd == end && errno != ERANGE;
+    }
+    line = end + 2;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool HubHttpServer::begin() {
+  listenFd_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (listenFd_ < 0) {
+    return false;
+  }
+  int one = 1;
+  setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port_);
+  if (bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+      listen(listenFd_, MAX_CONNECTIONS) < 0) {
+    ::close(listenFd_);
+    listenFd_ = -1;
+    return false;
+  }
+  setNonBlocking(listenFd_);
+  return true;
+}
+
+size_t HubHttpServer::activeConnections() const {
+  size_t count = 0;
+  for (const Connection& connection : connections_) {
+    count += connection.active() ? 1 : 0;
+  }
+  return count;
+}
+
+void HubHttpServer::handleClient() {
+  if (listenFd_ < 0) {
+    return;
+  }
+  acceptConnections();
+  for (Connection& connection : connections_) {
+    connection.servedThisPass = false;
+    if (connection.active()) {
+      receive(connection);
+    }
+  }
+
+  for (size_t level = 0; level < REQUEST_PRIORITY_CLASSES; ++level) {
+    RequestPriority priority = static_cast<RequestPriority>(level);
+    size_t budget = priority == RequestPriority::Page ? PAGE_REQUESTS_PER_PASS : SIZE_MAX;
+    for (Connection& connection : connections_) {
+      if (connection.active() && budget > 0) {
+        budget -= servePending(connection, priority, budget);
+      }
+    }
+  }
+
+  // Only page requests that could have been served count: a POST still waiting
+  // for its body, or a request of another class, is not page load.
+  bool backlog = false;
+  for (const Connection& connection : connections_) {
+    RequestPriority priority;
+    if (connection.active() && !connection.hasPendingOutput() && pendingPriority(connection, priority) &&
+        priority == RequestPriority::Page && requestComplete(connection)) {
+      ++stats_.deferred;
+      backlog = true;
+    }
+  }
+  pageBacklogPasses_ = backlog ? pageBacklogPasses_ + 1 : 0;
+}
+
+HubHttpServer::Connection* HubHttpServer::freeSlot() {
+  for (Connection& connection : connections_) {
+    if (!connection.active()) {
+      return &connection;
+    }
+  }
+  return nullptr;
+}
+
+// Keep-alive connections from polling displays would otherwise hold every slot;
+// the one idle the longest gives way. Idle means between requests or stuck part
+// way through one; a complete request or a response in flight is never cut off.
+HubHttpServer::Connection* HubHttpServer::longestIdleSlot() {
+  Connection* oldest = nullptr;
+  for (Connection& connection : connections_) {
+    if (connection.hasPendingOutput() || (connection.rxLength > 0 && !partialRequest(connection))) {
+      continue;
+    }
+    if (oldest == nullptr || (long)(connection.lastActivityMs - oldest->lastActivityMs) < 0) {
+      oldest = &connection;
+    }
+  }
+  return oldest;
+}
+
+void HubHttpServer::acceptConnections() {
+  while (true) {
+    Connection* slot = freeSlot();
+    if (slot == nullptr) {
+      fd_set readable;
+      FD_ZERO(&readable);
+      FD_SET(listenFd_, &readable);
+      timeval noWait = {0, 0};
+      if (select(listenFd_ + 1, &readable, nullptr, nullptr, &noWait) <= 0) {
+        return;
+      }
+      slot = longestIdleSlot();
+      if (slot == nullptr) {
+        return;
+      }
+      close(*slot);
+      ++stats_.evictedIdle;
+    }
+    sockaddr_in peer = {};
+    socklen_t peerLength = sizeof(peer);
+    int fd = accept(listenFd_, reinterpret_cast<sockaddr*>(&peer), &peerLength);
+    if (fd < 0) {
+      return;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setNonBlocking(fd);
+    slot->fd = fd;
+    slot->remoteIp = peer.sin_addr.s_addr;
+    slot->lastActivityMs = millis();
+    slot->requests = 0;
+    slot->failed = false;
+    slot->awaitingBody = false;
+    slot->rxLength = 0;
+    slot->txLength = 0;
+    slot->txSent = 0;
+    slot->staticRemaining = 0;
+    ++stats_.accepted;
+  }
+}
+
+void HubHttpServer::close(Connection& connection) {
+  if (connection.fd >= 0) {
+    ::close(connection.fd);
+  }
+  connection.fd = -1;
+  connection.awaitingBody = false;
+  connection.rxLength = 0;
+  connection.txLength = 0;
+  connection.txSent = 0;
+  connection.staticRemaining = 0;
+}
+
+// Finishes pending output, reads whatever has arrived and enforces the idle and
+// request timeouts. Returns false when the connection was closed.
+bool HubHttpServer::receive(Connection& connection) {
+  bool flushed = !connection.hasPendingOutput() || connection.flush();
+  if (connection.failed) {
+    ++stats_.socketErrors;
+    close(connection);
+    return false;
+  }
+  if (!flushed) {
+    return true;
+  }
+  if (!connection.keepAlive && connection.requests > 0) {
+    close(connection);
+    return false;
+  }
+
+  unsigned long now = millis();
+  if (connection.rxLength < RX_BUFFER_SIZE) {
+    int received = recv(connection.fd, connection.rx + connection.rxLength, RX_BUFFER_SIZE - connection.rxLength, 0);
+    if (received == 0 || (received < 0 && !wouldBlock())) {
+      close(connection);
+      return false;
+    }
+    if (received > 0) {
+      if (connection.rxLength == 0) {
+        connection.requestStartMs = now;
+      }
+      connection.awaitingBody = false;  // Re-checked when the request is next processed.
+      connection.rxLength += received;
+      connection.rx[connection.rxLength] = '\0';
+      connection.lastActivityMs = now;
+    }
+  }
+
+  bool idle = connection.rxLength == 0 && (unsigned long)(now - connection.lastActivityMs) >= IDLE_TIMEOUT_MS;
+  bool stalled = connection.rxLength > 0 && (unsigned long)(now - connection.requestStartMs) >= REQUEST_TIMEOUT_MS &&
+                 partialRequest(connection);
+  if (idle || stalled) {
+    ++stats_.timedOut;
+    close(connection);
+    return false;
+  }
+  return true;
+}
+
+// True while the request at the front of the buffer is still arriving. A full
+// buffer without a header end counts as complete: it is answered with a 431.
+bool HubHttpServer::partialRequest(const Connection& connection) const {
+  if (connection.rxLength == 0) {
+    return false;
+  }
+  if (connection.awaitingBody) {
+    return true;
+  }
+  return connection.rxLength < RX_BUFFER_SIZE && findHeaderEnd(connection.rx, connection.rxLength) == nullptr;
+}
+
+// True once the request at the front of the buffer has arrived whole, body and
+// all, or is bound to be rejected at once (bad or oversized Content-Length,
+// headers that overflow the buffer).
+bool HubHttpServer::requestComplete(const Connection& connection) const {
+  const char* headerEnd = findHeaderEnd(connection.rx, connection.rxLength);
+  if (headerEnd == nullptr) {
+    return connection.rxLength == RX_BUFFER_SIZE;
+  }
+  size_t contentLength;
+  size_t headerLength = headerEnd - connection.rx;
+  if (!findContentLength(connection.rx, headerEnd, contentLength) ||
+      contentLength > RX_BUFFER_SIZE - headerLength) {
+    return true;
+  }
+  return connection.rxLength >= headerLength + contentLength;
+}
+
+// Reports the class of the request at the front of the receive buffer, once its
+// headers are complete. Requests that will be rejected count as Control so the
+// cheap error reply goes out at once.
+bool HubHttpServer::pendingPriority(const Connection& connection, RequestPriority& priority) const {
+  const char* data = connection.rx;
+  if (findHeaderEnd(data, connection.rxLength) == nullptr) {
+    priority = RequestPriority::Control;
+    return connection.rxLength == RX_BUFFER_SIZE;
+  }
+  const char* lineEnd = strstr(data, "\r\n");
+  const char* path = static_cast<const char*>(memchr(data, ' ', lineEnd - data));
+  HttpMethod method;
+  if (path == data + 3 && memcmp(data, "GET", 3) == 0) {
+    method = HttpMethod::Get;
+  } else if (path == data + 4 && memcmp(data, "POST", 4) == 0) {
+    method = HttpMethod::Post;
+  } else {
+    priority = RequestPriority::Control;
+    return true;
+  }
+  ++path;
+  const char* pathEnd = path;
+  while (pathEnd < lineEnd && *pathEnd != ' ' && *pathEnd != '?') {
+    ++pathEnd;
+  }
+  priority = classify_ ? classify_(method, path, pathEnd - path) : RequestPriority::Poll;
+  return true;
+}
+
+// Serves requests of the given class from the front of the connection's buffer,
+// up to budget of them; stops at the first request of another class so a
+// connection's responses stay in request order. Returns the number served.
+size_t HubHttpServer::servePending(Connection& connection, RequestPriority priority, size_t budget) {
+  size_t served = 0;
+  RequestPriority pending;
+  while (served < budget && !connection.hasPendingOutput() && pendingPriority(connection, pending) &&
+         pending == priority) {
+    if (!processRequest(connection)) {
+      break;
+    }
+    ++served;
+    ++stats_.requests;
+    ++stats_.served[static_cast<size_t>(priority)];
+    if (connection.servedThisPass) {
+      ++stats_.pipelined;
+    }
+    connection.servedThisPass = true;
+    // A failed response (write error, stalled blocking flush, short stream) may
+    // have been cut short, so the connection cannot carry another one.
+    bool flushed = connection.flush();
+    if (connection.failed) {
+      ++stats_.socketErrors;
+      close(connection);
+      break;
+    }
+    if (!flushed) {
+      break;
+    }
+    if (!connection.keepAlive) {
+      close(connection);
+      break;
+    }
+  }
+  return served;
+}
+
+void HubHttpServer::rejectRequest(Connection& connection, int status) {
+  ++stats_.malformed;
+  connection.keepAlive = false;
+  connection.awaitingBody = false;
+  connection.rxLength = 0;
+  connection.send(status, "text/plain", httpStatusReason(status));
+}
+
+// Parses and dispatches one complete request from the front of the receive
+// buffer. Returns false while the request is still incomplete.
+bool HubHttpServer::processRequest(Connection& connection) {
+  char* data = connection.rx;
+  const char* headerEnd = findHeaderEnd(data, connection.rxLength);
+  if (headerEnd == nullptr) {
+    if (connection.rxLength == RX_BUFFER_SIZE) {
+      rejectRequest(connection, 431);
+      return true;
+    }
+    return false;
+  }
+
+  // Request line: METHOD SP target SP version CRLF
+  char* lineEnd = strstr(data, "\r\n");
+  char* methodEnd = static_cast<char*>(memchr(data, ' ', lineEnd - data));
+  char* targetEnd = methodEnd ? static_cast<char*>(memchr(methodEnd + 1, ' ', lineEnd - methodEnd - 1)) : nullptr;
+  if (methodEnd == nullptr || targetEnd == nullptr) {
+    rejectRequest(connection, 400);
+    return true;
+  }
+  HubHttpRequest request = {};
+  size_t methodLength = methodEnd - data;
+  if (methodLength == 3 && memcmp(data, "GET", 3) == 0) {
+    request.method = HttpMethod::Get;
+  } else if (methodLength == 4 && memcmp(data, "POST", 4) == 0) {
+    request.method = HttpMethod::Post;
+  } else {
+    rejectRequest(connection, 405);
+    return true;
+  }
+  bool http11 = (lineEnd - targetEnd - 1) == 8 && memcmp(targetEnd + 1, "HTTP/1.1", 8) == 0;
+
+  // Headers: only the few the hub acts on are picked out. Nothing is written
+  // into the buffer until the whole request has arrived, so an incomplete POST
+  // is parsed again from scratch on the next pass.
+  int connectionHeader = 0;  // 1 = keep-alive, -1 = close
+  char* etag = nullptr;
+  char* etagEnd = nullptr;
+  char* line = lineEnd + 2;
+  while (line < headerEnd - 2) {
+    char* end = strstr(line, "\r\n");
+    char* colon = static_cast<char*>(memchr(line, ':', end - line));
+    if (colon != nullptr) {
+      char* value = colon + 1;
+      while (value < end && *value == ' ') {
+        ++value;
+      }
+      size_t nameLength = colon - line;
+      size_t valueLength = end - value;
+      if (headerNameIs(line, nameLength, "Connection")) {
+        if (headerNameIs(value, valueLength, "close")) {
+          connectionHeader = -1;
+        } else if (headerNameIs(value, valueLength, "keep-alive")) {
+          connectionHeader = 1;
+        }
+      } else if (headerNameIs(line, nameLength, "If-None-Match")) {
+        etag = value;
+        etagEnd = end;
+      }
+    }
+    line = end + 2;
+  }
+
+  size_t headerLength = headerEnd - data;
+  size_t contentLength;
+  if (!findContentLength(data, headerEnd, contentLength)) {
+    rejectRequest(connection, 400);
+    return true;
+  }
+  // headerLength never exceeds the buffer, so this cannot wrap the way a sum could.
+  if (contentLength > RX_BUFFER_SIZE - headerLength) {
+    rejectRequest(connection, 413);
+    return true;
+  }
+  // Same test as requestComplete().
+  if (connection.rxLength < headerLength + contentLength) {
+    connection.awaitingBody = true;
+    return false;
+  }
+  connection.awaitingBody = false;
+  if (etag != nullptr) {
+    *etagEnd = '\0';
+    request.ifNoneMatch = etag;
+  } else {
+    request.ifNoneMatch = "";
+  }
+
+  request.path = methodEnd + 1;
+  const char* queryStart = static_cast<const char*>(memchr(request.path, '?', targetEnd - request.path));
+  request.pathLength = (queryStart ? queryStart : targetEnd) - request.path;
+  if (request.method == HttpMethod::Post) {
+    request.query = headerEnd;
+    request.queryLength = contentLength;
+  } else if (queryStart != nullptr) {
+    request.query = queryStart + 1;
+    request.queryLength = targetEnd - queryStart - 1;
+  } else {
+    request.query = "";
+    request.queryLength = 0;
+  }
+  request.remoteIp = connection.remoteIp;
+
+  ++connection.requests;
+  connection.keepAlive = (http11 ? connectionHeader >= 0 : connectionHeader > 0) &&
+                         connection.requests < MAX_REQUESTS_PER_CONNECTION;
+  connection.responded = false;
+  dispatch_(request, connection);
+  if (!connection.responded) {
+    connection.send(500, "text/plain", "No response");
+  }
+
+  size_t consumed = headerLength + contentLength;
+  memmove(connection.rx, connection.rx + consumed, connection.rxLength - consumed);
+  connection.rxLength -= consumed;
+  connection.rx[connection.rxLength] = '\0';
+  connection.requestStartMs = millis();
+  return true;
+}
+
+bool HubHttpServer::Connection::flush() {
+  while (txSent < txLength) {
+    int sent = ::send(fd, tx + txSent, txLength - txSent, 0);
+    if (sent < 0) {
+      failed = failed || !wouldBlock();
+      return false;
+    }
+    txSent += sent;
+  }
+  txLength = 0;
+  txSent = 0;
+  while (staticRemaining > 0) {
+    int sent = ::send(fd, staticBody, staticRemaining, 0);
+    if (sent < 0) {
+      failed = failed || !wouldBlock();
+      return false;
+    }
+    staticBody += sent;
+    staticRemaining -= sent;
+  }
+  return true;
+}
+
+// Only used when a response outgrows the transmit buffer; waits for the socket
+// to drain, bounded by BLOCKING_FLUSH_LIMIT_MS.
+void HubHttpServer::Connection::flushBlocking() {
+  unsigned long start = millis();
+  while (!flush() && !failed) {
+    if ((unsigned long)(millis() - start) >= BLOCKING_FLUSH_LIMIT_MS) {
+      failed = true;
+      return;
+    }
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(fd, &writable);
+    timeval wait = {0, 20000};
+    select(fd + 1, nullptr, &writable, nullptr, &wait);
+  }
+}
+
+void HubHttpServer::Connection::append(const uint8_t* data, size_t length) {
+  while (length > 0 && !failed) {
+    if (txLength == TX_BUFFER_SIZE) {
+      flushBlocking();
+      continue;
+    }
+    size_t chunk = TX_BUFFER_SIZE - txLength;
+    if (chunk > length) {
+      chunk = length;
+    }
+    memcpy(tx + txLength, data, chunk);
+    txLength += chunk;
+    data += chunk;
+    length -= chunk;
+  }
+}
+
+bool HubHttpServer::Connection::writeHead(int status, const char* contentType, size_t contentLength,
+                                          const char* extraHeaders) {
+  char head[384];
+  size_t headLength = formatResponseHead(head, sizeof(head), status, contentType, contentLength, extraHeaders,
+                                         keepAlive);
+  if (headLength == 0) {
+    keepAlive = false;
+    headLength = formatResponseHead(head, sizeof(head), 500, "text/plain", 0, "", false);
+    append(reinterpret_cast<const uint8_t*>(head), headLength);
+    return false;
+  }
+  append(reinterpret_cast<const uint8_t*>(head), headLength);
+  return true;
+}
+
+void HubHttpServer::Connection::send(int status, const char* contentType, const char* body, size_t length,
+                                     const char* extraHeaders) {
+  responded = true;
+  if (writeHead(status, contentType, length, extraHeaders)) {
+    append(reinterpret_cast<const uint8_t*>(body), length);
+  }
+}
+
+void HubHttpServer::Connection::sendStatic(int status, const char* contentType, const uint8_t* body, size_t length,
+                                           const char* extraHeaders) {
+  responded = true;
+  if (writeHead(status, contentType, length, extraHeaders)) {
+    staticBody = body;
+    staticRemaining = length;
+  }
+}
+
+// Reads straight into the transmit buffer and drains it whenever it fills, the
+// same way append() handles an oversized dynamic body.
+void HubHttpServer::Connection::sendStream(int status, const char* contentType, size_t length, HttpBodyReader reader,
+                                           void* context, const char* extraHeaders) {
+  responded = true;
+  if (!writeHead(status, contentType, length, extraHeaders)) {
+    return;
+  }
+  while (length > 0 && !failed) {
+    if (txLength == TX_BUFFER_SIZE) {
+      flushBlocking();
+      continue;
+    }
+    size_t chunk = TX_BUFFER_SIZE - txLength;
+    if (chunk > length) {
+      chunk = length;
+    }
+    size_t read = reader(context, tx + txLength, chunk);
+    if (read == 0) {
+      // The client was promised length bytes; closing is the only honest ending.
+      failed = true;
+      return;
+    }
+    txLength += read;
+    length -= read;
+  }
+}
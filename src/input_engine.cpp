@@ -0,0 +1,134 @@
+#include "input_engine.h"
+
+InputEngine::InputEngine(GpioPort& gpio, const uint8_t* pins, size_t count, const Config& config)
+    : gpio_(gpio), config_(config), count_(count < MAX_BUTTONS ? count : MAX_BUTTONS), buttons_() {
+  for (size_t i = 0; i < count_; ++i) {
+    buttons_[i].engine = this;
+    buttons_[i].index = static_cast<uint8_t>(i);
+    buttons_[i].pin = pins[i];
+  }
+}
+
+void InputEngine::begin() {
+  for (size_t i = 0; i < count_; ++i) {
+    Button& button = buttons_[i];
+    gpio_.configureInput(button.pin);
+    button.pressed = isActive(gpio_.readHigh(button.pin));
+    button.windowOpen = false;
+    gpio_.attachEdgeInterrupt(button.pin, edgeIsr, &button);
+  }
+}
+
+void IRAM_ATTR InputEngine::edgeIsr(void* button) {
+  Button* source = static_cast<Button*>(button);
+  source->engine->captureEdge(source->index);
+}
+
+void IRAM_ATTR InputEngine::captureEdge(uint8_t index) {
+  Edge edge = {index, gpio_.readHigh(buttons_[index].pin), gpio_.micros()};
+  edges_.push(edge);
+  edgeCount_ = edgeCount_ + 1;
+  if (edgeNotify_ != nullptr) {
+    edgeNotify_(edgeNotifyContext_);
+  }
+}
+
+bool InputEngine::injectPress(uint8_t button, uint32_t timestampUs, uint8_t tag) {
+  if (button < 1 || button > count_) {
+    return false;
+  }
+  Injection injection = {button, tag, timestampUs};
+  return injected_.push(injection);
+}
+
+void InputEngine::process() {
+  // Both queues are in time order; taking the older head each time keeps wired
+  // and injected presses in the order they happened.
+  Edge edge;
+  Injection injection;
+  bool haveEdge = edges_.peek(edge);
+  bool haveInjection = injected_.peek(injection);
+  while (haveEdge || haveInjection) {
+    if (haveEdge && (!haveInjection || static_cast<int32_t>(edge.timestampUs - injection.timestampUs) <= 0)) {
+      edges_.pop(edge);
+      apply(buttons_[edge.index], isActive(edge.high), edge.timestampUs);
+      haveEdge = edges_.peek(edge);
+    } else {
+      injected_.pop(injection);
+      ++stats_.injected;
+      InjectResult result = {injection.tag,
+                             acceptPress(static_cast<uint8_t>(injection.button - 1), injection.timestampUs)};
+      injectResults_.push(result);
+      haveInjection = injected_.peek(injection);
+    }
+  }
+  uint32_t now = gpio_.micros();
+  for (size_t i = 0; i < count_; ++i) {
+    Button& button = buttons_[i];
+    if (!button.windowOpen || now - button.windowStartUs < config_.debounceUs) {
+      continue;
+    }
+    button.windowOpen = false;
+    bool active = isActive(gpio_.readHigh(button.pin));
+    if (active != button.pressed) {
+      ++stats_.resyncs;
+      apply(button, active, now);
+    }
+  }
+}
+
+void InputEngine::apply(Button& button, bool active, uint32_t timestampUs) {
+  if (button.windowOpen && timestampUs - button.windowStartUs < config_.debounceUs) {
+    ++stats_.bounces;
+    return;
+  }
+  button.windowOpen = false;
+  if (active == button.pressed) {
+    return;
+  }
+  button.pressed = active;
+  button.windowOpen = true;
+  button.windowStartUs = timestampUs;
+  if (active) {
+    acceptPress(button.index, timestampUs);
+  }
+}
+
+InputEngine::InjectOutcome InputEngine::acceptPress(uint8_t index, uint32_t timestampUs) {
+  // Signed, so an injected press stamped before the last accepted one (it can
+  // reach the queue after a later edge was processed) is capped, not wrapped.
+  if (anyPressAccepted_ &&
+      static_cast<int32_t>(timestampUs - lastPressUs_) < static_cast<int32_t>(config_.minPressIntervalUs)) {
+    ++stats_.rateLimited;
+    return InjectOutcome::RateLimited;
+  }
+  anyPressAccepted_ = true;
+  lastPressUs_ = timestampUs;
+  ++stats_.presses;
+  Press press = {static_cast<uint8_t>(index + 1), timestampUs};
+  if (pressHook_ != nullptr) {
+    pressHook_(pressHookContext_, press);
+  }
+  if (!presses_.push(press)) {
+    ++stats_.pressOverflows;
+    return InjectOutcome::Overflow;
+  }
+  return InjectOutcome::Accepted;
+}
+
+bool InputEngine::hasOpenWindows() const {
+  for (size_t i = 0; i < count_; ++i) {
+    if (buttons_[i].windowOpen) {
+      return true;
+    }
+  }
+  return false;
+}
+
+InputEngine::Stats InputEngine::stats() const {
+  Stats stats = stats_;
+  stats.edges = edgeCount_;
+  stats.edgeOverflows = edges_.dropped();
+  stats.injectOverflows = injected_.dropped();
+  return stats;
+}
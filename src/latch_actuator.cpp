@@ -0,0 +1,79 @@
+#include "latch_actuator.h"
+
+#include <Arduino.h>
+
+bool LatchActuator::begin(uint8_t pin, uint32_t pulseMs) {
+  pin_ = pin;
+  pulseMs_ = pulseMs;
+  digitalWrite(pin_, LOW);
+  pinMode(pin_, OUTPUT);
+  return xTaskCreatePinnedToCore(taskEntry, "latch", TASK_STACK_SIZE, this, TASK_PRIORITY, &task_, TASK_CORE) ==
+         pdPASS;
+}
+
+bool IRAM_ATTR LatchActuator::onButtonEdge(uint8_t button, uint32_t timestampUs) {
+  uint8_t armed = armedButton_.load(std::memory_order_acquire);
+  if (armed == NO_BUTTON) {
+    return false;
+  }
+  if (button != armed) {
+    armedButton_.store(NO_BUTTON, std::memory_order_release);
+    return false;
+  }
+  return fire(Source::FinalButton, timestampUs);
+}
+
+bool IRAM_ATTR LatchActuator::fire(Source source, uint32_t requestedAtUs) {
+  if (task_ == nullptr || fired_.exchange(true, std::memory_order_acq_rel)) {
+    return false;
+  }
+  armedButton_.store(NO_BUTTON, std::memory_order_release);
+  requestedAtUs_.store(requestedAtUs, std::memory_order_relaxed);
+  requestSource_.store(static_cast<uint8_t>(source), std::memory_order_release);
+  if (xPortInIsrContext()) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task_, &woken);
+    portYIELD_FROM_ISR(woken);
+  } else {
+    xTaskNotifyGive(task_);
+  }
+  return true;
+}
+
+void LatchActuator::rearm() {
+  armedButton_.store(NO_BUTTON, std::memory_order_release);
+  fired_.store(false, std::memory_order_release);
+}
+
+LatchActuator::Stats LatchActuator::stats() const {
+  Stats stats;
+  stats.fired = firedCount_;
+  stats.lastLatencyUs = lastLatencyUs_;
+  stats.maxLatencyUs = maxLatencyUs_;
+  stats.lastSource = static_cast<Source>(lastSource_);
+  stats.armedButton = armedButton_.load(std::memory_order_acquire);
+  stats.active = active_.load(std::memory_order_acquire);
+  return stats;
+}
+
+void LatchActuator::taskEntry(void* self) {
+  static_cast<LatchActuator*>(self)->run();
+}
+
+void LatchActuator::run() {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    digitalWrite(pin_, HIGH);
+    uint32_t latencyUs = micros() - requestedAtUs_.load(std::memory_order_relaxed);
+    active_.store(true, std::memory_order_release);
+    lastLatencyUs_ = latencyUs;
+    if (latencyUs > maxLatencyUs_) {
+      maxLatencyUs_ = latencyUs;
+    }
+    lastSource_ = requestSource_.load(std::memory_order_acquire);
+    firedCount_ = firedCount_ + 1;
+    vTaskDelay(pdMS_TO_TICKS(pulseMs_));
+    digitalWrite(pin_, LOW);
+    active_.store(false, std::memory_order_release);
+  }
+}
@@ -1,182 +1,438 @@
 #include <Arduino.h>
 #include <WiFi.h>
+#include <WebSocketsServer.h>
+
+#include "arduino_gpio.h"
+#include "arduino_wifi_scanner.h"
+#include "boot_profiler.h"
+#include "channel_planner.h"
+#include "client_registry.h"
+#include "cooperative_scheduler.h"
+#include "event_log.h"
+#include "game_snapshot.h"
+#include "generated/web_assets.h"
+#include "http_common.h"
+#include "hub_dns.h"
+#include "history_log.h"
+#include "hub_http_server.h"
+#include "input_engine.h"
+#include "latch_actuator.h"
+#include "latency_histogram.h"
+#include "route_table.h"
+#include "timer_wheel.h"
+#include "udp_input.h"
+
+#if HUB_HTTP_SERVER == HUB_HTTP_SERVER_WEBSERVER
 #include <WebServer.h>
+#endif
 
 namespace {
 
 constexpr char HUB_SSID[] = "MissionControlHub";
 constexpr char HUB_PASSWORD[] = "LostSignal2024";
-constexpr uint8_t HUB_CHANNEL = 6;
+// Build with -DHUB_WIFI_CHANNEL=N (1-11) to pin the access point to a channel;
+// 0 picks the least congested one at power-on.
+#ifndef HUB_WIFI_CHANNEL
+#define HUB_WIFI_CHANNEL 0
+#endif
+static_assert(HUB_WIFI_CHANNEL <= ChannelPlanner::MAX_CHANNEL, "HUB_WIFI_CHANNEL must be 0 or 1-11");
+// Used when the scan fails.
+constexpr uint8_t HUB_FALLBACK_CHANNEL = 6;
+constexpr uint32_t RTC_CHANNEL_MAGIC = 0x43480000;  // "CH" above the channel number.
+// Resolved to the AP address by the hub's DNS responder, e.g. http://mission.hub/control.
+constexpr char HUB_DNS_NAME[] = "mission.hub";
+constexpr uint16_t GM_SOCKET_PORT = 81;
 constexpr unsigned long SEQUENCE_ERROR_FLASH_MS = 2500;
+constexpr uint32_t MISSION_CLOCK_DURATION_MS = 60UL * 60 * 1000;
+constexpr uint32_t MISSION_CLOCK_STEP_MS = 60UL * 1000;
+constexpr uint32_t MISSION_CLOCK_MAX_MS = 99UL * 60 * 1000;
+// Game timer wheel: 10 ms ticks, one turn every 2.56 s.
+constexpr uint32_t GAME_TIMER_TICK_MS = 10;
+constexpr size_t GAME_TIMER_SLOTS = 256;
+constexpr size_t MAX_GAME_TIMERS = 16;
+constexpr size_t MAX_LOOP_JOBS = 12;
+constexpr size_t MAX_BOOT_MARKS = 16;
+constexpr uint8_t LATCH_PIN = 25;
+constexpr uint32_t LATCH_PULSE_MS = 750;
+// Puzzle 3 buttons 1-5, wired to ground.
+constexpr uint8_t BUTTON_PINS[] = {32, 33, 27, 14, 13};
+constexpr uint32_t BUTTON_DEBOUNCE_US = 20000;
+constexpr uint32_t BUTTON_MIN_PRESS_INTERVAL_US = 120000;
+// Above the loop task, below the latch task.
+constexpr UBaseType_t INPUT_TASK_PRIORITY = LatchActuator::TASK_PRIORITY - 1;
+constexpr uint32_t INPUT_TASK_STACK_SIZE = 2048;
+constexpr uint32_t INPUT_WINDOW_POLL_MS = 5;
+// Next-poll hints returned by /state, by how soon the current state is likely to change.
+constexpr unsigned long POLL_HINT_PUZZLE1_MS = 2500;
+constexpr unsigned long POLL_HINT_PUZZLE2_MS = 1500;
+constexpr unsigned long POLL_HINT_PUZZLE3_MS = 400;
+constexpr unsigned long POLL_HINT_COMPLETE_MS = 5000;
+constexpr size_t MAX_BATCH_COMMANDS = 32;
+constexpr size_t EVENT_LOG_CAPACITY = 256;
+constexpr size_t EVENT_STREAM_BATCH = 32;
+constexpr uint8_t EVENT_FRAME_VERSION = 1;
+constexpr uint8_t EVENT_FRAME_FLAG_DROPPED = 0x01;
+constexpr uint32_t NO_EVENT_CURSOR = UINT32_MAX;
+constexpr size_t MAX_DISPLAY_REPORTS = 8;
+constexpr size_t DISPLAY_ID_LENGTH = 8;
+// Per bucket and /telemetry beacon; a script reporting every few seconds never gets near it.
+constexpr unsigned long MAX_TELEMETRY_COUNT = 10000;
+constexpr size_t ROUTE_TABLE_SLOTS = 64;
+constexpr size_t PROBE_TABLE_SLOTS = 16;
+// Admission control: below these free-heap levels requests of the class are shed
+// with a 503 so Control requests always find memory to run in.
+constexpr uint32_t SHED_PAGE_BELOW_FREE_HEAP = 40 * 1024;
+constexpr uint32_t SHED_POLL_BELOW_FREE_HEAP = 20 * 1024;
+// With HubHttpServer, Page requests are also shed once page loads have been held
+// back this many passes in a row. One display loading a page clears in two or three.
+constexpr uint32_t SHED_PAGE_BACKLOG_PASSES = 8;
+constexpr unsigned RETRY_AFTER_PAGE_S = 3;
+constexpr unsigned RETRY_AFTER_POLL_S = 1;
 
+// web/dcd.html renders this sequence client-side; keep its Puzzle 3 template in sync.
 constexpr uint8_t BUTTON_SEQUENCE[] = {4, 1, 5, 1, 3, 5, 4, 2, 1, 3, 2, 4, 5, 3, 1};
 constexpr size_t BUTTON_SEQUENCE_LENGTH = sizeof(BUTTON_SEQUENCE) / sizeof(BUTTON_SEQUENCE[0]);
 
 enum class GameState { Puzzle1, Puzzle2, Puzzle3, MissionComplete };
 enum class ConduitConfirmResult { Accepted, AlreadyConfirmed, WrongState };
+enum class ButtonPressResult { Ignored, Correct, Incorrect, Completed };
+enum class ChannelSource : uint8_t { Override, Scan, Kept, Fallback };
+enum class GmCommandType : uint8_t { Remote, PuzzleButton, ConfirmConduits, Clock };
+
+// One GM input, shared by the HTTP endpoints and the GM socket.
+struct GmCommand {
+  GmCommandType type;
+  char value;  // Remote letter, or puzzle button id 1-5.
+};
+
+// How much animation a DCD display runs; see the .profile-* rules in web/hub.css.
+enum class RenderProfile : uint8_t { Unset, Full, Lite, Static };
+
+// Query arguments, parsed once per request into fixed buffers before the handler
+// runs. Text values longer than their buffer are cut short and set `truncated`,
+// which makes them fail validation instead of silently matching a shorter value.
+struct RequestArgs {
+  enum : uint16_t {
+    BTN = 1 << 0,
+    ID = 1 << 1,
+    CMDS = 1 << 2,
+    PROFILE = 1 << 3,
+    FPS = 1 << 4,
+    SESSION = 1 << 5,
+    CLIENT = 1 << 6,
+    RENDER = 1 << 7,
+    FETCH_TIMES = 1 << 8,
+    RENDER_TIMES = 1 << 9,
+    DROPPED_FRAMES = 1 << 10,
+    CLIENT_ERRORS = 1 << 11,
+  };
+
+  uint16_t present = 0;
+  bool truncated = false;
+  char btn = '\0';                          // First character of btn=.
+  long idNumber = 0;                         // id= as a number (puzzle buttons).
+  char id[DISPLAY_ID_LENGTH + 2] = {};       // id= as text (display ids).
+  char cmds[MAX_BATCH_COMMANDS * 3] = {};    // cmds=, comma-separated GM commands.
+  char profile[8] = {};                      // profile=
+  float fps = 0;                             // fps=
+  unsigned long sessionNumber = 0;           // session= (history sessions).
+  char client[DISPLAY_ID_LENGTH + 2] = {};   // c=, the sending script's client id.
+  unsigned long renderMs = 0;                // r=, the client's last poll-to-paint time.
+  LatencyHistogram fetchTimes = {};          // f=, bucket counts (see parseBucketCounts()).
+  LatencyHistogram renderTimes = {};         // rt=
+  unsigned long droppedFrames = 0;           // df=
+  unsigned long clientErrors = 0;            // e=
+
+  bool has(uint16_t arg) const { return (present & arg) != 0; }
+};
+
+struct Route;
+
+struct HttpRequest {
+  const Route& route;
+  const RequestArgs& args;
+  const char* ifNoneMatch;  // Empty when the client sent none.
+  ClientRegistry::Client& client;
+  HttpResponse& response;
+};
+
+using RouteHandler = void (*)(const HttpRequest& request);
+
+struct Route {
+  HttpMethod method;
+  const char* path;
+  RequestPriority priority;
+  RouteHandler handler;
+  const web_assets::Asset* asset;  // Served by handleAssetRoute; null for other routes.
+};
+
+// Canned answer to an OS connectivity probe or favicon request. These skip
+// admission and argument parsing; the reply is a fixed status, body and headers.
+struct ProbeRoute {
+  HttpMethod method;
+  const char* path;
+  int status;
+  const char* contentType;
+  const char* body;
+  const char* headers;
+};
+
+using GameTimers = TimerWheel<GAME_TIMER_SLOTS, MAX_GAME_TIMERS>;
+using LoopScheduler = CooperativeScheduler<MAX_LOOP_JOBS>;
+using BootProfile = BootProfiler<MAX_BOOT_MARKS>;
+
+struct AdmissionStats {
+  uint32_t admitted[REQUEST_PRIORITY_CLASSES];
+  uint32_t shed[REQUEST_PRIORITY_CLASSES];
+  uint32_t minFreeHeap;
+};
+
+// Mission countdown. The hub is the only clock: it keeps the time left at an
+// anchor on its millis() timeline and pages count down from that themselves
+// (web/clock.js). version changes on every start, pause, adjustment and expiry.
+struct MissionClock {
+  bool running;
+  uint32_t anchorMs;
+  uint32_t remainingAtAnchorMs;
+  uint32_t version;
+};
 
+struct DisplayReport {
+  char id[DISPLAY_ID_LENGTH + 1];
+  RenderProfile profile;
+  RenderProfile assignedProfile;
+  uint16_t fpsTenths;
+  unsigned long lastReportAt;
+};
+
+#if HUB_HTTP_SERVER == HUB_HTTP_SERVER_HUBHTTP
+HubHttpServer server(80);
+#else
 WebServer server(80);
+#endif
+WebSocketsServer gmSocket(GM_SOCKET_PORT);
 GameState currentState = GameState::Puzzle1;
 size_t nextSequenceIndex = 0;
 bool latchTriggered = false;
 bool conduitsVerified = false;
 bool sequenceError = false;
 unsigned long sequenceErrorExpiresAt = 0;
+GameTimers gameTimers(GAME_TIMER_TICK_MS);
+LoopScheduler loopJobs([]() -> uint32_t { return micros(); });
+BootProfile bootProfile([]() -> uint32_t { return micros(); });
+// False until the staged part of startup has run; until then only the holding
+// page, assets and /debug/boot are served.
+bool startupComplete = false;
+size_t nextStartupStage = 0;
+// A game in progress came back from the snapshot; history continues its session.
+bool resumedGame = false;
+ArduinoWifiScanner wifiScanner;
+ChannelPlanner channelPlanner(wifiScanner);
+uint8_t wifiChannel = HUB_FALLBACK_CHANNEL;
+ChannelSource wifiChannelSource = ChannelSource::Fallback;
+// The channel chosen at power-on. It survives every other reset, so a reboot
+// mid-show comes back where the clients last saw the hub, without a scan.
+RTC_NOINIT_ATTR uint32_t rtcChannelRecord;
+GameTimers::TimerId sequenceErrorTimer = GameTimers::NO_TIMER;
+MissionClock missionClock = {false, 0, MISSION_CLOCK_DURATION_MS, 0};
+GameTimers::TimerId missionClockTimer = GameTimers::NO_TIMER;
+// Bumped on every change visible to displays. Seeded randomly at boot so a client
+// that polled before a reboot cannot mistake the new state for one it has seen.
+uint32_t stateVersion = 0;
+uint32_t lastBroadcastVersion = 0;
+// Random per boot; lets GM panels tell whether an event cursor came from this run.
+uint32_t bootId = 0;
+EventLog<EVENT_LOG_CAPACITY> eventLog;
+// Next event each GM socket client wants; NO_EVENT_CURSOR until it subscribes.
+uint32_t gmEventCursors[WEBSOCKETS_SERVER_CLIENT_MAX];
+DisplayReport displayReports[MAX_DISPLAY_REPORTS] = {};
+AdmissionStats admissionStats = {{}, {}, UINT32_MAX};
+uint32_t probeHits = 0;
+HubDnsResponder dnsResponder;
+LatchActuator latch;
+ArduinoGpioPort gpioPort;
+InputEngine buttonInput(gpioPort, BUTTON_PINS, sizeof(BUTTON_PINS), {BUTTON_DEBOUNCE_US,
+                                                                     BUTTON_MIN_PRESS_INTERVAL_US, true});
+TaskHandle_t inputTask = nullptr;
+UdpInputServer udpInput;
+// Every press awaiting its ack has a result on the way, which must fit the queue.
+static_assert(UdpInputServer::MAX_PENDING <= InputEngine::INJECT_QUEUE_CAPACITY,
+              "UDP presses outstanding must not outnumber InputEngine's inject results");
+GameSnapshotStore snapshotStore;
+HistoryLog history;
+ClientRegistry clients;
+// Next event log record the history job has not collected yet.
+uint32_t historyCursor = 0;
 
-String buildSequenceStatusHtml();
-bool isSequenceErrorActive();
-void clearSequenceError();
-void markSequenceError();
+uint32_t missionClockRemainingMs(uint32_t nowMs);
 
-String storyTextForState() {
-  switch (currentState) {
-    case GameState::Puzzle1:
-      return F(
-          "<h2>Lost Signal</h2>"
-          "<p>The Orion expedition just lost contact with Mission Control. Decode the incoming "
-          "message to re-align the antenna array.</p>"
-          "<div class='transmission'>"
-          "<h3>Last Transmission</h3>"
-          "<pre>#4 🌍  #7 🪐  #2 ☄️  #9 ⭐&#10;02: ⚡ 🔋 🔋 ☁️&#10;PWR: 🔺 🟩 🔵</pre>"
-          "<p class='hint'>Each icon matches a laminated key hidden in the room.</p>"
-          "<ul class='cards'>"
-          "<li>Card 1 — <strong>Number Key</strong>: use the numbers after each # to pick words.</li>"
-          "<li>Cards 2 &amp; 3 — <strong>Emoji Keys</strong>: earth=oxygen, planet=system, meteor=offline, "
-          "star=restore, bolt=power, battery=battery, cloud=conduit, shapes=set the order.</li>"
-          "<li>Card 4 — <strong>Rule Key</strong>: read the first line before the second.</li>"
-          "<li>Card 5 — <strong>Operation Hint</strong>: say each emoji aloud and stitch the sentences together.</li>"
-          "<li>Card 6 — <strong>Confirmation</strong>: once you reach <em>system</em> and <em>restore</em>, shout them "
-          "to flag Mission Control.</li>"
-          "</ul>"
-          "<p><em>Awaiting GM confirmation...</em></p>");
-    case GameState::Puzzle2:
-      if (!conduitsVerified) {
-        return F(
-            "<h2>Power Conduits</h2>"
-            "<p>Great work! Route power through the damaged conduits on the floor. Match the colored strings "
-            "to the floor diagram to bring the system back online.</p>"
-            "<p class='hint'>Await GM visual confirmation before entering the command code.</p>");
-      }
-      return F(
-          "<h2>Power Conduits</h2>"
-          "<p>Conduits verified.</p>"
-          "<div class='flash-banner'>POWER STABLE - BUTTON ACCESS UNLOCKED</div>"
-          "<div class='callout'>264</div>"
-          "<p>Power conduits aligned. Access to Button Control Chamber granted. Proceed to repower oxygen supply.</p>");
-    case GameState::Puzzle3: {
-      String html = F(
-          "<h2>Button Sequence</h2>"
-          "<p>The lock is open, but the drive bay still needs a precise manual input. "
-          "Use all five buttons to enter the correct sequence.</p>"
-          "<p><small>Stay sharp. Incorrect inputs reset the buffer.</small></p>");
-      html += buildSequenceStatusHtml();
-      if (isSequenceErrorActive()) {
-        html += F("<div class='alert flash'>Incorrect input detected. Sequence reset.</div>");
-      }
-      return html;
-    }
-    case GameState::MissionComplete:
-      return F(
-          "<h2>Mission Complete</h2>"
-          "<p>Oxygen restored. Returning to Earth.</p>"
-          "<p class='success'>Mission accomplished!</p>");
-    default:
-      return F("<p>Unknown state.</p>");
-  }
+GameSnapshot captureGameSnapshot() {
+  uint32_t seconds = (missionClockRemainingMs(millis()) + 999) / 1000;
+  return {static_cast<uint8_t>(currentState), conduitsVerified, latchTriggered,
+          static_cast<uint8_t>(nextSequenceIndex), missionClock.running, static_cast<uint16_t>(seconds)};
 }
 
-String gameStateLabel() {
-  switch (currentState) {
-    case GameState::Puzzle1:
-      return F("Puzzle 1 — Message Decoding");
-    case GameState::Puzzle2:
-      return F("Puzzle 2 — Power Conduits");
-    case GameState::Puzzle3:
-      return F("Puzzle 3 — Button Sequence");
-    case GameState::MissionComplete:
-      return F("Mission Complete");
-    default:
-      return F("Unknown");
+void markStateChanged() {
+  ++stateVersion;
+  snapshotStore.save(captureGameSnapshot(), millis());
+}
+
+void logGameEvent(GameEventType type, uint8_t a = 0, uint8_t b = 0, uint8_t c = 0) {
+  eventLog.append(type, millis(), a, b, c);
+}
+
+void setGameState(GameState next) {
+  if (next == currentState) {
+    return;
   }
+  logGameEvent(GameEventType::Transition, static_cast<uint8_t>(currentState), static_cast<uint8_t>(next));
+  currentState = next;
 }
 
-void triggerLatch() {
+// requestedAtUs is when the triggering input arrived; the latch task measures
+// its actuation latency from there. The pulse itself may already be under way if
+// the armed final button fired it from the input path.
+void triggerLatch(uint32_t requestedAtUs) {
   if (latchTriggered) {
     return;
   }
   latchTriggered = true;
+  latch.fire(LatchActuator::Source::Game, requestedAtUs);
+  logGameEvent(GameEventType::LatchFired);
   Serial.println(F("[Latch] Servo/solenoid triggered to release tacklebox bottom."));
 }
 
+// Arms the latch task with the last button of the sequence once it is the only
+// press left, so that press can fire the latch ahead of the game logic.
+void updateLatchArming() {
+  bool finalPressNext = currentState == GameState::Puzzle3 && !latchTriggered &&
+                        nextSequenceIndex == BUTTON_SEQUENCE_LENGTH - 1;
+  latch.armFinalButton(finalPressNext ? BUTTON_SEQUENCE[BUTTON_SEQUENCE_LENGTH - 1] : LatchActuator::NO_BUTTON);
+}
+
 void resetSequenceTracking() {
   nextSequenceIndex = 0;
+  updateLatchArming();
 }
 
 void clearSequenceError() {
+  gameTimers.cancel(sequenceErrorTimer);
+  sequenceErrorTimer = GameTimers::NO_TIMER;
   sequenceError = false;
   sequenceErrorExpiresAt = 0;
 }
 
+// Timer callback: the flash ends as a state change of its own, so displays and
+// GM panels hear about it without having to poll for it.
+void endSequenceErrorFlash(void*) {
+  sequenceErrorTimer = GameTimers::NO_TIMER;
+  clearSequenceError();
+  markStateChanged();
+}
+
 void markSequenceError() {
+  gameTimers.cancel(sequenceErrorTimer);
   sequenceError = true;
-  sequenceErrorExpiresAt = millis() + SEQUENCE_ERROR_FLASH_MS;
+  uint32_t now = millis();
+  sequenceErrorExpiresAt = now + SEQUENCE_ERROR_FLASH_MS;
+  sequenceErrorTimer = gameTimers.schedule(now, SEQUENCE_ERROR_FLASH_MS, endSequenceErrorFlash, nullptr);
 }
 
 bool isSequenceErrorActive() {
-  if (!sequenceError) {
-    return false;
-  }
-  if ((long)(millis() - sequenceErrorExpiresAt) >= 0) {
-    clearSequenceError();
-    return false;
+  return sequenceError;
+}
+
+uint32_t missionClockRemainingMs(uint32_t nowMs) {
+  if (!missionClock.running) {
+    return missionClock.remainingAtAnchorMs;
   }
-  return true;
+  uint32_t elapsed = nowMs - missionClock.anchorMs;
+  return elapsed < missionClock.remainingAtAnchorMs ? missionClock.remainingAtAnchorMs - elapsed : 0;
 }
 
-String buildSequenceStatusHtml() {
-  String html;
-  html.reserve(512);
-  html += F("<div class='sequence-status'>");
-  if (nextSequenceIndex < BUTTON_SEQUENCE_LENGTH) {
-    html += F("<div class='current-step'><span>Next Input</span><strong>");
-    html += String(BUTTON_SEQUENCE[nextSequenceIndex]);
-    html += F("</strong></div>");
-  } else {
-    html += F("<div class='current-step'><span>Next Input</span><strong>✓</strong></div>");
+void expireMissionClock(void*);
+
+// Re-anchors the clock at now. Every change is a state change, which is all that
+// displays and GM panels need to re-sync; nothing is sent while it just runs.
+void setMissionClock(bool running, uint32_t remainingMs, char action) {
+  gameTimers.cancel(missionClockTimer);
+  missionClockTimer = GameTimers::NO_TIMER;
+  missionClock.running = running && remainingMs > 0;
+  missionClock.anchorMs = millis();
+  missionClock.remainingAtAnchorMs = remainingMs;
+  ++missionClock.version;
+  if (missionClock.running) {
+    missionClockTimer = gameTimers.schedule(missionClock.anchorMs, remainingMs, expireMissionClock, nullptr);
   }
-  html += F("<div class='sequence-row'>");
-  for (size_t i = 0; i < BUTTON_SEQUENCE_LENGTH; ++i) {
-    const char* stateClass = "pending";
-    if (i < nextSequenceIndex) {
-      stateClass = "done";
-    } else if (i == nextSequenceIndex) {
-      stateClass = "active";
-    }
-    html += "<span class='seq-step ";
-    html += stateClass;
-    html += "'>";
-    html += String(BUTTON_SEQUENCE[i]);
-    html += "</span>";
+  markStateChanged();
+  uint32_t seconds = (remainingMs + 999) / 1000;
+  logGameEvent(GameEventType::ClockChanged, static_cast<uint8_t>(action), static_cast<uint8_t>(seconds / 60),
+               static_cast<uint8_t>(seconds % 60));
+}
+
+void expireMissionClock(void*) {
+  missionClockTimer = GameTimers::NO_TIMER;
+  setMissionClock(false, 0, 'e');
+  Serial.println(F("[Clock] Mission time expired."));
+}
+
+// action is 's' (start/resume), 'p' (pause), 'u' (+1 min) or 'd' (-1 min).
+// Returns false when the action does not apply to the clock as it stands.
+bool adjustMissionClock(char action) {
+  uint32_t remaining = missionClockRemainingMs(millis());
+  switch (action) {
+    case 's':
+      if (missionClock.running || remaining == 0) {
+        return false;
+      }
+      setMissionClock(true, remaining, action);
+      return true;
+    case 'p':
+      if (!missionClock.running) {
+        return false;
+      }
+      setMissionClock(false, remaining, action);
+      return true;
+    case 'u':
+      remaining = remaining + MISSION_CLOCK_STEP_MS < MISSION_CLOCK_MAX_MS ? remaining + MISSION_CLOCK_STEP_MS
+                                                                           : MISSION_CLOCK_MAX_MS;
+      setMissionClock(missionClock.running, remaining, action);
+      return true;
+    case 'd':
+      if (remaining == 0) {
+        return false;
+      }
+      remaining = remaining > MISSION_CLOCK_STEP_MS ? remaining - MISSION_CLOCK_STEP_MS : 0;
+      setMissionClock(missionClock.running, remaining, action);
+      return true;
+    default:
+      return false;
   }
-  html += F("</div>");
-  html += F("<p class='sequence-note'>Pattern: 4 1 5 1 3 5 4 2 1 3 2 4 5 3 1</p>");
-  html += F("</div>");
-  return html;
 }
 
 void resetGame() {
-  currentState = GameState::Puzzle1;
+  logGameEvent(GameEventType::Reset, static_cast<uint8_t>(currentState));
+  setGameState(GameState::Puzzle1);
   latchTriggered = false;
+  latch.rearm();
   conduitsVerified = false;
   clearSequenceError();
   resetSequenceTracking();
+  setMissionClock(false, MISSION_CLOCK_DURATION_MS, 'r');
+  markStateChanged();
   Serial.println(F("[Game] Reset to Puzzle 1."));
 }
 
-void completeMission() {
-  currentState = GameState::MissionComplete;
+void completeMission(uint32_t requestedAtUs) {
+  setGameState(GameState::MissionComplete);
   clearSequenceError();
-  triggerLatch();
+  triggerLatch(requestedAtUs);
+  updateLatchArming();
+  if (missionClock.running) {
+    // Freeze the countdown on the team's final time.
+    setMissionClock(false, missionClockRemainingMs(millis()), 'p');
+  }
+  markStateChanged();
   Serial.println(F("[Game] Mission Complete triggered."));
 }
 
@@ -187,30 +443,33 @@ void advanceToPuzzle(GameState target) {
   }
 
   if (target == GameState::Puzzle2 && currentState == GameState::Puzzle1) {
-    currentState = GameState::Puzzle2;
+    setGameState(GameState::Puzzle2);
     conduitsVerified = false;
     clearSequenceError();
+    markStateChanged();
     Serial.println(F("[Game] Advanced to Puzzle 2."));
     return;
   }
 
   if (target == GameState::Puzzle3 && currentState == GameState::Puzzle2) {
-    currentState = GameState::Puzzle3;
+    setGameState(GameState::Puzzle3);
     clearSequenceError();
     resetSequenceTracking();
+    markStateChanged();
     Serial.println(F("[Game] Advanced to Puzzle 3. Sequence tracking reset."));
     return;
   }
 
   if (target == GameState::MissionComplete && currentState == GameState::Puzzle3) {
-    completeMission();
+    completeMission(micros());
     return;
   }
 
   Serial.println(F("[Game] Invalid state transition requested."));
 }
 
-void handleRemoteButton(char button) {
+bool handleRemoteButton(char button) {
+  logGameEvent(GameEventType::RemoteButton, static_cast<uint8_t>(button));
   switch (button) {
     case 'A':
     case 'a':
@@ -230,18 +489,22 @@ void handleRemoteButton(char button) {
     case 'D':
     case 'd':
       Serial.println(F("[Remote] Button D pressed. Forcing completion."));
-      completeMission();
+      completeMission(micros());
       break;
     default:
       Serial.println(F("[Remote] Unknown button."));
-      break;
+      return false;
   }
+  return true;
 }
 
-void registerButtonPress(uint8_t buttonId) {
+// pressedAtUs is when the press happened: the edge or UDP receive time for
+// buttons, so a completion's latch latency includes any wait in the press queue.
+ButtonPressResult registerButtonPress(uint8_t buttonId, uint32_t pressedAtUs) {
   if (currentState != GameState::Puzzle3) {
+    logGameEvent(GameEventType::ButtonPress, buttonId);
     Serial.println(F("[Buttons] Ignored press outside Puzzle 3."));
-    return;
+    return ButtonPressResult::Ignored;
   }
 
   Serial.printf("[Buttons] Received button %u\n", buttonId);
@@ -250,275 +513,1603 @@ void registerButtonPress(uint8_t buttonId) {
   if (buttonId == expected) {
     clearSequenceError();
     nextSequenceIndex++;
+    updateLatchArming();
+    markStateChanged();
+    logGameEvent(GameEventType::ButtonPress, buttonId, expected, static_cast<uint8_t>(nextSequenceIndex));
     Serial.printf("[Buttons] Progress %u/%u\n", static_cast<unsigned>(nextSequenceIndex),
                   static_cast<unsigned>(BUTTON_SEQUENCE_LENGTH));
     if (nextSequenceIndex >= BUTTON_SEQUENCE_LENGTH) {
-      completeMission();
+      completeMission(pressedAtUs);
+      return ButtonPressResult::Completed;
     }
-  } else {
-    Serial.printf("[Buttons] Incorrect input (expected %u). Sequence reset.\n", expected);
-    markSequenceError();
-    resetSequenceTracking();
+    return ButtonPressResult::Correct;
   }
+
+  Serial.printf("[Buttons] Incorrect input (expected %u). Sequence reset.\n", expected);
+  markSequenceError();
+  resetSequenceTracking();
+  markStateChanged();
+  logGameEvent(GameEventType::ButtonPress, buttonId, expected, 0);
+  return ButtonPressResult::Incorrect;
 }
 
 ConduitConfirmResult confirmConduitsAligned() {
   if (currentState != GameState::Puzzle2) {
+    logGameEvent(GameEventType::ConduitConfirm, static_cast<uint8_t>(ConduitConfirmResult::WrongState));
     Serial.println(F("[Conduits] Confirmation ignored (not in Puzzle 2)."));
     return ConduitConfirmResult::WrongState;
   }
   if (conduitsVerified) {
+    logGameEvent(GameEventType::ConduitConfirm, static_cast<uint8_t>(ConduitConfirmResult::AlreadyConfirmed));
     Serial.println(F("[Conduits] Already verified."));
     return ConduitConfirmResult::AlreadyConfirmed;
   }
   conduitsVerified = true;
+  markStateChanged();
+  logGameEvent(GameEventType::ConduitConfirm, static_cast<uint8_t>(ConduitConfirmResult::Accepted));
   Serial.println(F("[Conduits] GM confirmed power conduits. Code 264 unlocked."));
   return ConduitConfirmResult::Accepted;
 }
 
-String buildDcdPage() {
-  String page = F(
-      "<!DOCTYPE html><html lang='en'><head><meta charset='UTF-8'><meta name='viewport' "
-      "content='width=device-width,initial-scale=1'>"
-      "<title>Mission Control DCD</title>"
-      "<style>"
-      "body{font-family:'Segoe UI',sans-serif;background:#030712;color:#f8fafc;margin:0;padding:2rem;"
-      "min-height:100vh;overflow:hidden;position:relative;display:flex;align-items:center;justify-content:center;}"
-      ".warp-field{position:fixed;top:0;left:0;width:100%;height:100%;overflow:hidden;z-index:0;"
-      "background:radial-gradient(circle at top,#0f172a 0%,#01030a 65%,#000103 100%);}"
-      ".warp-line{position:absolute;width:2px;height:140px;background:linear-gradient(180deg,rgba(59,130,246,0),"
-      "rgba(59,130,246,.6),rgba(59,130,246,0));filter:blur(0.3px);animation:warpSlide 2.8s linear infinite;"
-      "opacity:.25;}"
-      ".warp-line:nth-child(3n){animation-duration:3.4s;opacity:.35;width:3px;}"
-      ".warp-line:nth-child(5n){animation-duration:2.1s;opacity:.2;height:180px;}"
-      "@keyframes warpSlide{0%{transform:translate3d(0,-150%,0);}100%{transform:translate3d(0,150%,0);}}"
-      ".panel{position:relative;z-index:1;max-width:720px;width:100%;background:rgba(15,23,42,.9);padding:2rem;"
-      "border:1px solid rgba(148,163,184,.4);border-radius:8px;box-shadow:0 15px 35px rgba(0,0,0,.4);}"
-      "h1{margin-top:0;font-weight:600;letter-spacing:.08em;text-transform:uppercase;font-size:1rem;color:#94a3b8;}"
-      "h2{margin-bottom:.5rem;color:#e0f2fe;}p{line-height:1.6;} .callout{font-size:2.5rem;font-weight:700;"
-      "letter-spacing:.3rem;text-align:center;margin:1rem auto;padding:.5rem;border:1px solid #38bdf8;"
-      "border-radius:4px;color:#38bdf8;} .success{color:#4ade80;font-weight:600;}"
-      ".transmission{margin:1.5rem 0;padding:1rem;border:1px solid rgba(148,163,184,.4);border-radius:6px;"
-      "background:rgba(2,6,23,.8);} .transmission h3{margin-top:0;color:#bae6fd;text-transform:uppercase;"
-      "letter-spacing:.1em;font-size:.85rem;} .transmission pre{background:#020617;padding:.8rem;border-radius:4px;"
-      "font-size:1.1rem;line-height:1.4;overflow:auto;} .hint{color:#94a3b8;font-style:italic;margin:.8rem 0;}"
-      ".cards{margin:0;padding-left:1.2rem;} .cards li{margin:.35rem 0;}"
-      ".sequence-status{margin:1.5rem 0;padding:1rem;border:1px solid rgba(148,163,184,.4);border-radius:6px;"
-      "background:rgba(15,23,42,.7);} .current-step{display:flex;justify-content:space-between;align-items:center;"
-      "font-size:1.2rem;margin-bottom:1rem;} .current-step span{text-transform:uppercase;font-size:.75rem;"
-      "letter-spacing:.1em;color:#94a3b8;} .current-step strong{font-size:2.5rem;color:#fbbf24;"
-      "font-weight:700;letter-spacing:.2em;} .sequence-row{display:flex;flex-wrap:wrap;gap:.35rem;}"
-      ".seq-step{width:2.2rem;height:2.2rem;border-radius:4px;display:flex;align-items:center;justify-content:center;"
-      "font-weight:600;font-size:1.1rem;border:1px solid rgba(148,163,184,.4);} .seq-step.done{background:#1d4ed8;"
-      "border-color:#2563eb;color:#e0f2fe;} .seq-step.active{background:#fbbf24;border-color:#f59e0b;color:#0f172a;"
-      "transform:scale(1.1);} .seq-step.pending{background:rgba(15,23,42,.8);color:#94a3b8;}"
-      ".sequence-note{margin-top:.75rem;font-size:.85rem;color:#94a3b8;letter-spacing:.05em;}"
-      ".alert{margin-top:1rem;padding:.75rem;border-radius:6px;border:1px solid #fecaca;color:#fee2e2;"
-      "background:#7f1d1d;} .flash{animation:flashError .35s alternate 6;} @keyframes flashError{from{background:#7f1d1d;}"
-      "to{background:#b91c1c;}}"
-      ".flash-banner{margin:1rem 0;padding:.75rem;border-radius:6px;border:1px solid rgba(56,189,248,.8);"
-      "text-align:center;font-weight:700;letter-spacing:.15em;color:#e0f2fe;background:rgba(14,165,233,.15);"
-      "animation:flashPulse .65s ease-in-out infinite alternate;box-shadow:0 0 12px rgba(56,189,248,.35);}"
-      "@keyframes flashPulse{from{background:rgba(14,165,233,.15);color:#bae6fd;}to{background:rgba(14,165,233,.35);"
-      "color:#f0f9ff;box-shadow:0 0 22px rgba(56,189,248,.6);}}"
-      ".status-bar{margin-top:1rem;font-size:.8rem;color:#94a3b8;}"
-      "</style></head><body>"
-      "<div class='warp-field'>"
-      "<div class='warp-line' style='left:5%;animation-delay:-1s'></div>"
-      "<div class='warp-line' style='left:12%;animation-delay:-2.2s'></div>"
-      "<div class='warp-line' style='left:22%;animation-delay:-.4s'></div>"
-      "<div class='warp-line' style='left:33%;animation-delay:-1.6s'></div>"
-      "<div class='warp-line' style='left:45%;animation-delay:-2.8s'></div>"
-      "<div class='warp-line' style='left:57%;animation-delay:-.9s'></div>"
-      "<div class='warp-line' style='left:66%;animation-delay:-2.1s'></div>"
-      "<div class='warp-line' style='left:74%;animation-delay:-.2s'></div>"
-      "<div class='warp-line' style='left:83%;animation-delay:-1.3s'></div>"
-      "<div class='warp-line' style='left:92%;animation-delay:-2.6s'></div>"
-      "</div>"
-      "<div class='panel'><h1>Mission Control</h1>"
-      "<div id='dcd-content'>");
-  page += storyTextForState();
-  page += F("</div><div class='status-bar' id='sync-status'>Live link established.</div></div>"
-           "<script>"
-           "const statusEl=document.getElementById('sync-status');"
-           "const contentEl=document.getElementById('dcd-content');"
-           "async function refreshContent(){"
-           "try{const resp=await fetch('/dcd-fragment',{cache:'no-store'});"
-           "if(!resp.ok){throw new Error('HTTP '+resp.status);}"
-           "const html=await resp.text();"
-           "contentEl.innerHTML=html;"
-           "statusEl.textContent='Link stable • '+new Date().toLocaleTimeString();"
-           "}catch(err){statusEl.textContent='Link unstable: '+err;}}"
-           "refreshContent();"
-           "setInterval(refreshContent,700);"
-           "</script>"
-           "</body></html>");
-  return page;
-}
-
-String buildControlPanelPage() {
-  String page = F(
-      "<!DOCTYPE html><html lang='en'><head><meta charset='UTF-8'><meta name='viewport' "
-      "content='width=device-width,initial-scale=1'>"
-      "<title>GM Control Panel</title>"
-      "<style>"
-      "body{font-family:'Segoe UI',sans-serif;background:#030712;color:#e2e8f0;margin:0;padding:2rem;"
-      "min-height:100vh;position:relative;overflow:hidden;display:flex;align-items:center;justify-content:center;}"
-      ".warp-field{position:fixed;top:0;left:0;width:100%;height:100%;overflow:hidden;z-index:0;"
-      "background:radial-gradient(circle at top,#0f172a 0%,#01030a 65%,#000103 100%);}"
-      ".warp-line{position:absolute;width:2px;height:140px;background:linear-gradient(180deg,rgba(59,130,246,0),"
-      "rgba(59,130,246,.6),rgba(59,130,246,0));filter:blur(0.3px);animation:warpSlide 2.8s linear infinite;"
-      "opacity:.25;}"
-      ".warp-line:nth-child(3n){animation-duration:3.4s;opacity:.35;width:3px;}"
-      ".warp-line:nth-child(5n){animation-duration:2.1s;opacity:.2;height:180px;}"
-      "@keyframes warpSlide{0%{transform:translate3d(0,-150%,0);}100%{transform:translate3d(0,150%,0);}}"
-      ".content{position:relative;z-index:1;width:100%;max-width:1100px;}"
-      ".grid{display:grid;grid-template-columns:repeat(auto-fit,minmax(220px,1fr));gap:1rem;}"
-      ".card{background:#1e293b;padding:1rem;border-radius:8px;border:1px solid rgba(148,163,184,.3);}"
-      "button{width:100%;padding:.8rem;border:none;border-radius:6px;font-size:1rem;font-weight:600;"
-      "cursor:pointer;margin-top:.5rem;}button.remote{background:#38bdf8;color:#0f172a;}"
-      "button.remote:nth-of-type(2){background:#fb7185;}button.remote:nth-of-type(3){background:#fbbf24;}"
-      "button.remote:nth-of-type(4){background:#22c55e;}button.puzzle{background:#94a3b8;color:#0f172a;margin:.25rem 0;}"
-      "button.action{background:#4ade80;color:#0f172a;}"
-      ".status{margin-top:1rem;padding:.5rem;border-radius:6px;background:#0f172a;border:1px solid #334155;"
-      "font-family:monospace;} a{color:#38bdf8;}"
-      "</style></head><body>"
-      "<div class='warp-field'>"
-      "<div class='warp-line' style='left:8%;animation-delay:-1.4s'></div>"
-      "<div class='warp-line' style='left:16%;animation-delay:-.6s'></div>"
-      "<div class='warp-line' style='left:28%;animation-delay:-2.1s'></div>"
-      "<div class='warp-line' style='left:37%;animation-delay:-.3s'></div>"
-      "<div class='warp-line' style='left:49%;animation-delay:-1.7s'></div>"
-      "<div class='warp-line' style='left:61%;animation-delay:-2.8s'></div>"
-      "<div class='warp-line' style='left:72%;animation-delay:-.8s'></div>"
-      "<div class='warp-line' style='left:84%;animation-delay:-2.3s'></div>"
-      "<div class='warp-line' style='left:93%;animation-delay:-.2s'></div>"
-      "</div>"
-      "<div style='position:relative;z-index:1;'>"
-      "<h1>GM Control Panel</h1>"
-      "<p>Current state: <strong>");
-  page += gameStateLabel();
-  page += F("</strong></p><div class='grid'>"
-            "<div class='card'><h2>GM Remote</h2>"
-            "<button class='remote' onclick=\"sendAction('/remote?btn=A')\">Remote A (Puzzle 1 → 2)</button>"
-            "<button class='remote' onclick=\"sendAction('/remote?btn=B')\">Remote B (Puzzle 2 → 3)</button>"
-            "<button class='remote' onclick=\"sendAction('/remote?btn=C')\">Remote C (Reset)</button>"
-            "<button class='remote' onclick=\"sendAction('/remote?btn=D')\">Remote D (Force Complete)</button>"
-            "</div>"
-            "<div class='card'><h2>Puzzle Buttons</h2>"
-            "<p>Simulate wired + wireless button presses while in Puzzle 3.</p>");
-  for (uint8_t button = 1; button <= 5; ++button) {
-    page += "<button class='puzzle' onclick=\"sendAction('/puzzle-button?id=" + String(button) +
-            "')\">Button " + String(button) + "</button>";
-  }
-  page += F("</div>"
-            "<div class='card'><h2>Puzzle 2 Tools</h2>"
-            "<p>Use after visually confirming players aligned every conduit correctly.</p>"
-            "<button class='action' onclick=\"sendAction('/confirm-conduits')\">Confirm Conduits Aligned</button>"
-            "</div></div>"
-            "<div class='status' id='status'>Status log will appear here.</div>"
-            "<script>"
-            "async function sendAction(path){const status=document.getElementById('status');"
-            "status.textContent='Sending '+path+' ...';"
-        "try{const resp=await fetch(path);const text=await resp.text();"
-        "status.textContent=text;}catch(err){status.textContent='Error: '+err;}}"
-        "</script>"
-            "<p><a href='/'>View DCD display</a></p></div></body></html>");
-  return page;
-}
-
-void sendBadRequest(const String& message) {
-  server.send(400, "text/plain", "Bad request: " + message);
-}
-
-void handleRoot() {
-  server.send(200, "text/html", buildDcdPage());
-}
-
-void handleDcdFragment() {
-  server.send(200, "text/html", storyTextForState());
-}
-
-void handleControlPanel() {
-  server.send(200, "text/html", buildControlPanelPage());
-}
-
-void handleRemoteEndpoint() {
-  if (!server.hasArg("btn") || server.arg("btn").isEmpty()) {
-    sendBadRequest(F("missing btn parameter"));
-    return;
-  }
-  char btn = server.arg("btn").charAt(0);
-  handleRemoteButton(btn);
-  server.send(200, "text/plain", String("Remote input accepted: ") + btn);
-}
-
-void handlePuzzleButtonEndpoint() {
-  if (!server.hasArg("id") || server.arg("id").isEmpty()) {
-    sendBadRequest(F("missing id parameter"));
-    return;
-  }
-  int value = server.arg("id").toInt();
-  if (value < 1 || value > 5) {
-    sendBadRequest(F("button id must be 1-5"));
-    return;
+// Parses the compact command syntax used on the GM socket: "rA".."rD" for the
+// remote, "b1".."b5" for puzzle buttons, "cc" for conduit confirmation and
+// "ts"/"tp"/"tu"/"td" to start, pause, add or take a minute on the mission clock.
+bool parseGmCommand(const char* text, size_t length, GmCommand& command) {
+  if (length != 2) {
+    return false;
+  }
+  switch (text[0]) {
+    case 'r':
+      command = {GmCommandType::Remote, text[1]};
+      return true;
+    case 'b':
+      if (text[1] < '1' || text[1] > '5') {
+        return false;
+      }
+      command = {GmCommandType::PuzzleButton, static_cast<char>(text[1] - '0')};
+      return true;
+    case 'c':
+      if (text[1] != 'c') {
+        return false;
+      }
+      command = {GmCommandType::ConfirmConduits, 0};
+      return true;
+    case 't':
+      if (text[1] == '\0' || strchr("spud", text[1]) == nullptr) {
+        return false;
+      }
+      command = {GmCommandType::Clock, text[1]};
+      return true;
+    default:
+      return false;
   }
-  registerButtonPress(static_cast<uint8_t>(value));
-  server.send(200, "text/plain", String("Button press registered: ") + value);
 }
 
-void handleConfirmConduitsEndpoint() {
-  ConduitConfirmResult result = confirmConduitsAligned();
+const char* buttonPressOutcome(ButtonPressResult result) {
   switch (result) {
-    case ConduitConfirmResult::Accepted:
-      server.send(200, "text/plain", "Conduits confirmed. Code 264 unlocked.");
-      break;
-    case ConduitConfirmResult::AlreadyConfirmed:
-      server.send(200, "text/plain", "Conduits already verified.");
-      break;
-    case ConduitConfirmResult::WrongState:
+    case ButtonPressResult::Correct:
+      return "correct";
+    case ButtonPressResult::Incorrect:
+      return "incorrect";
+    case ButtonPressResult::Completed:
+      return "completed";
+    case ButtonPressResult::Ignored:
     default:
-      server.send(200, "text/plain", "Conduit confirmation ignored. Not in Puzzle 2.");
+      return "ignored";
+  }
+}
+
+// Applies a GM command, writes the reply text the HTTP endpoints have always sent
+// (pass a null reply to skip it) and returns a short outcome token for /batch.
+const char* runGmCommand(const GmCommand& command, char* reply, size_t replySize) {
+  switch (command.type) {
+    case GmCommandType::Remote: {
+      bool known = handleRemoteButton(command.value);
+      snprintf(reply, replySize, "Remote input accepted: %c", command.value);
+      return known ? "ok" : "unknown";
+    }
+    case GmCommandType::PuzzleButton: {
+      ButtonPressResult result = registerButtonPress(static_cast<uint8_t>(command.value), micros());
+      snprintf(reply, replySize, "Button press registered: %u", static_cast<unsigned>(command.value));
+      return buttonPressOutcome(result);
+    }
+    case GmCommandType::Clock: {
+      bool applied = adjustMissionClock(command.value);
+      uint32_t seconds = (missionClockRemainingMs(millis()) + 999) / 1000;
+      snprintf(reply, replySize, "Mission clock %s: %02lu:%02lu%s", applied ? "updated" : "unchanged",
+               static_cast<unsigned long>(seconds / 60), static_cast<unsigned long>(seconds % 60),
+               missionClock.running ? "" : " (stopped)");
+      return applied ? "ok" : "ignored";
+    }
+    case GmCommandType::ConfirmConduits:
+    default:
+      switch (confirmConduitsAligned()) {
+        case ConduitConfirmResult::Accepted:
+          snprintf(reply, replySize, "Conduits confirmed. Code 264 unlocked.");
+          return "accepted";
+        case ConduitConfirmResult::AlreadyConfirmed:
+          snprintf(reply, replySize, "Conduits already verified.");
+          return "already";
+        case ConduitConfirmResult::WrongState:
+        default:
+          snprintf(reply, replySize, "Conduit confirmation ignored. Not in Puzzle 2.");
+          return "wrong-state";
+      }
+  }
+}
+
+// Parses a comma-separated list of GM commands ("b4,b1,rA,cc"). Fails as a whole
+// on the first malformed entry so a batch is either applied completely or not at all.
+bool parseGmBatch(const char* text, GmCommand* commands, size_t maxCommands, size_t& count) {
+  count = 0;
+  while (*text != '\0') {
+    const char* end = strchr(text, ',');
+    size_t length = end ? static_cast<size_t>(end - text) : strlen(text);
+    if (count == maxCommands || !parseGmCommand(text, length, commands[count])) {
+      return false;
+    }
+    ++count;
+    text += length;
+    if (*text == ',') {
+      ++text;
+    }
+  }
+  return count > 0;
+}
+
+const char* renderProfileName(RenderProfile profile) {
+  switch (profile) {
+    case RenderProfile::Full:
+      return "full";
+    case RenderProfile::Lite:
+      return "lite";
+    case RenderProfile::Static:
+      return "static";
+    case RenderProfile::Unset:
+    default:
+      return "";
+  }
+}
+
+bool parseRenderProfile(const char* name, RenderProfile& profile) {
+  if (strcmp(name, "full") == 0) {
+    profile = RenderProfile::Full;
+  } else if (strcmp(name, "lite") == 0) {
+    profile = RenderProfile::Lite;
+  } else if (strcmp(name, "static") == 0) {
+    profile = RenderProfile::Static;
+  } else if (name[0] == '\0' || strcmp(name, "auto") == 0) {
+    profile = RenderProfile::Unset;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool isValidDisplayId(const char* id) {
+  size_t length = strlen(id);
+  if (length == 0 || length > DISPLAY_ID_LENGTH) {
+    return false;
+  }
+  for (size_t i = 0; i < length; ++i) {
+    if (!isalnum(static_cast<unsigned char>(id[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Finds the slot for a display id, claiming a free one or evicting the display
+// that has been silent the longest when the table is full.
+DisplayReport& displayReportFor(const char* id) {
+  DisplayReport* oldest = &displayReports[0];
+  for (DisplayReport& report : displayReports) {
+    if (strcmp(report.id, id) == 0) {
+      return report;
+    }
+  }
+  for (DisplayReport& report : displayReports) {
+    if (report.id[0] == '\0') {
+      oldest = &report;
       break;
+    }
+    if ((long)(report.lastReportAt - oldest->lastReportAt) < 0) {
+      oldest = &report;
+    }
+  }
+  memset(oldest, 0, sizeof(*oldest));
+  strncpy(oldest->id, id, DISPLAY_ID_LENGTH);
+  oldest->lastReportAt = millis();
+  return *oldest;
+}
+
+String buildDisplayReportsJson() {
+  String json;
+  json.reserve(112 * MAX_DISPLAY_REPORTS);
+  json += '[';
+  bool first = true;
+  unsigned long now = millis();
+  for (const DisplayReport& report : displayReports) {
+    if (report.id[0] == '\0') {
+      continue;
+    }
+    // seen counts any request from the display, so it goes stale as soon as polling stops.
+    const ClientRegistry::Client* client = clients.findById(report.id);
+    unsigned long lastSeenAt = client ? client->lastSeenMs : report.lastReportAt;
+    char entry[128];
+    snprintf(entry, sizeof(entry),
+             "%s{\"id\":\"%s\",\"p\":\"%s\",\"a\":\"%s\",\"fps\":%u.%u,\"age\":%lu,\"seen\":%lu}",
+             first ? "" : ",", report.id, renderProfileName(report.profile),
+             renderProfileName(report.assignedProfile), report.fpsTenths / 10, report.fpsTenths % 10,
+             (now - report.lastReportAt) / 1000, (now - lastSeenAt) / 1000);
+    json += entry;
+    first = false;
+  }
+  json += ']';
+  return json;
+}
+
+void sendBadRequest(const HttpRequest& request, const char* message) {
+  char body[112];
+  snprintf(body, sizeof(body), "Bad request: %s", message);
+  request.response.send(400, "text/plain", body);
+}
+
+void sendNotFound(HttpResponse& response) {
+  response.send(404, "text/plain", "Endpoint not found");
+}
+
+const char ASSET_CACHE_IMMUTABLE[] PROGMEM = "public, max-age=31536000, immutable";
+const char ASSET_CACHE_REVALIDATE[] PROGMEM = "no-cache";
+
+// Writes a precompressed asset straight from its flash mapping to the socket. The
+// header is formatted on the stack and the body pointer is handed to the response
+// as-is, so payload bytes are never staged in RAM regardless of the asset size.
+// Accept-Encoding is not consulted: every browser that loads the hub's pages
+// takes gzip, and there is no uncompressed copy to fall back to.
+void serveStaticAsset(const HttpRequest& request, const web_assets::Asset& asset, PGM_P cacheControl) {
+  char headers[192];
+  if (strcmp(request.ifNoneMatch, asset.etag) == 0) {
+    snprintf(headers, sizeof(headers), "ETag: %s\r\nCache-Control: %s\r\n", asset.etag, cacheControl);
+    request.response.send(304, asset.contentType, "", 0, headers);
+    return;
+  }
+  snprintf(headers, sizeof(headers),
+           "Content-Encoding: %s\r\n"
+           "ETag: %s\r\n"
+           "Cache-Control: %s\r\n",
+           asset.contentEncoding, asset.etag, cacheControl);
+  request.response.sendStatic(200, asset.contentType, asset.data, asset.length, headers);
+}
+
+void handleRoot(const HttpRequest& request) {
+  serveStaticAsset(request, web_assets::DCD_HTML, ASSET_CACHE_REVALIDATE);
+}
+
+// Hashed /assets/ URLs change whenever their content does, so they cache forever.
+void handleAssetRoute(const HttpRequest& request) {
+  serveStaticAsset(request, *request.route.asset, ASSET_CACHE_IMMUTABLE);
+}
+
+// Puzzle 1 and Mission Complete only change on a GM command, so displays can idle;
+// Puzzle 3 changes with every press the players make.
+unsigned long pollHintForState() {
+  switch (currentState) {
+    case GameState::Puzzle1:
+      return POLL_HINT_PUZZLE1_MS;
+    case GameState::Puzzle2:
+      return POLL_HINT_PUZZLE2_MS;
+    case GameState::Puzzle3:
+      return POLL_HINT_PUZZLE3_MS;
+    case GameState::MissionComplete:
+    default:
+      return POLL_HINT_COMPLETE_MS;
+  }
+}
+
+// Compact state snapshot rendered by the DCD (templates in web/dcd.html) and the
+// GM panel: v = state version, s = GameState index, c = conduits verified,
+// n = next sequence index, e = milliseconds left on the sequence error flash,
+// p = suggested delay before the next poll, k = mission clock version (fetch
+// /clock when it changes). A non-null type adds a "t" field
+// so the snapshot can share the GM socket with other messages.
+int formatStateJson(char* out, size_t size, const char* type) {
+  unsigned long errorRemainingMs = 0;
+  if (isSequenceErrorActive()) {
+    // The timer may land up to a tick after the nominal expiry.
+    long remaining = static_cast<long>(sequenceErrorExpiresAt - millis());
+    errorRemainingMs = remaining > 0 ? static_cast<unsigned long>(remaining) : 0;
+  }
+  return snprintf(out, size, "{%s%s%s\"v\":%lu,\"s\":%u,\"c\":%u,\"n\":%u,\"e\":%lu,\"p\":%lu,\"k\":%lu}",
+                  type ? "\"t\":\"" : "", type ? type : "", type ? "\"," : "",
+                  static_cast<unsigned long>(stateVersion), static_cast<unsigned>(currentState),
+                  conduitsVerified ? 1u : 0u, static_cast<unsigned>(nextSequenceIndex), errorRemainingMs,
+                  pollHintForState(), static_cast<unsigned long>(missionClock.version));
+}
+
+const char NO_STORE_HEADER[] = "Cache-Control: no-store\r\n";
+
+void handleStateEndpoint(const HttpRequest& request) {
+  char body[128];
+  int length = formatStateJson(body, sizeof(body), nullptr);
+  request.response.send(200, "application/json", body, length, NO_STORE_HEADER);
+}
+
+// Mission clock for web/clock.js: k = version, r = running, m = milliseconds left
+// at the anchor, a = anchor and h = now, both on the hub's millis() timeline.
+void handleClockEndpoint(const HttpRequest& request) {
+  char body[96];
+  int length = snprintf(body, sizeof(body), "{\"k\":%lu,\"r\":%u,\"m\":%lu,\"a\":%lu,\"h\":%lu}",
+                        static_cast<unsigned long>(missionClock.version), missionClock.running ? 1u : 0u,
+                        static_cast<unsigned long>(missionClock.remainingAtAnchorMs),
+                        static_cast<unsigned long>(missionClock.anchorMs), static_cast<unsigned long>(millis()));
+  request.response.send(200, "application/json", body, length, NO_STORE_HEADER);
+}
+
+void handleControlPanel(const HttpRequest& request) {
+  serveStaticAsset(request, web_assets::GM_HTML, ASSET_CACHE_REVALIDATE);
+}
+
+void sendGmCommandReply(const HttpRequest& request, const GmCommand& command) {
+  char reply[64];
+  runGmCommand(command, reply, sizeof(reply));
+  request.response.send(200, "text/plain", reply);
+}
+
+void handleRemoteEndpoint(const HttpRequest& request) {
+  if (request.args.btn == '\0') {
+    sendBadRequest(request, "missing btn parameter");
+    return;
+  }
+  sendGmCommandReply(request, {GmCommandType::Remote, request.args.btn});
+}
+
+void handlePuzzleButtonEndpoint(const HttpRequest& request) {
+  if (request.args.id[0] == '\0') {
+    sendBadRequest(request, "missing id parameter");
+    return;
+  }
+  long value = request.args.idNumber;
+  if (value < 1 || value > 5) {
+    sendBadRequest(request, "button id must be 1-5");
+    return;
+  }
+  sendGmCommandReply(request, {GmCommandType::PuzzleButton, static_cast<char>(value)});
+}
+
+void handleConfirmConduitsEndpoint(const HttpRequest& request) {
+  sendGmCommandReply(request, {GmCommandType::ConfirmConduits, 0});
+}
+
+// Applies an ordered list of GM commands in one request, e.g.
+// /batch?cmds=rA,cc,rB,b4,b1,b5. Nothing else runs between the commands, and the
+// reply lists each command's outcome plus the resulting state version.
+void handleBatchEndpoint(const HttpRequest& request) {
+  GmCommand commands[MAX_BATCH_COMMANDS];
+  size_t count = 0;
+  if (request.args.truncated || !parseGmBatch(request.args.cmds, commands, MAX_BATCH_COMMANDS, count)) {
+    sendBadRequest(request, "cmds must be 1-32 comma-separated commands (rA-rD, b1-b5, cc, ts/tp/tu/td)");
+    return;
+  }
+  String body;
+  body.reserve(48 + count * 14);
+  body += F("{\"results\":[");
+  for (size_t i = 0; i < count; ++i) {
+    if (i > 0) {
+      body += ',';
+    }
+    body += '"';
+    body += runGmCommand(commands[i], nullptr, 0);
+    body += '"';
+  }
+  char tail[48];
+  snprintf(tail, sizeof(tail), "],\"v\":%lu,\"s\":%u}", static_cast<unsigned long>(stateVersion),
+           static_cast<unsigned>(currentState));
+  body += tail;
+  request.response.send(200, "application/json", body.c_str(), body.length(), "");
+}
+
+// DCDs report their measured frame rate here; the reply carries any profile the
+// GM assigned so the display can switch without a reload.
+void handleDisplayReportEndpoint(const HttpRequest& request) {
+  const RequestArgs& args = request.args;
+  RenderProfile profile = RenderProfile::Unset;
+  if (!isValidDisplayId(args.client)) {
+    sendBadRequest(request, "c must be 1-8 alphanumeric characters");
+    return;
+  }
+  if (!parseRenderProfile(args.profile, profile)) {
+    sendBadRequest(request, "unknown profile");
+    return;
+  }
+  float fps = args.fps;
+  DisplayReport& report = displayReportFor(args.client);
+  report.profile = profile;
+  report.fpsTenths = static_cast<uint16_t>(constrain(fps, 0.0f, 240.0f) * 10.0f + 0.5f);
+  report.lastReportAt = millis();
+  request.response.send(200, "text/plain", renderProfileName(report.assignedProfile));
+}
+
+void handleDisplayProfileEndpoint(const HttpRequest& request) {
+  const char* id = request.args.id;
+  RenderProfile profile = RenderProfile::Unset;
+  if (!isValidDisplayId(id)) {
+    sendBadRequest(request, "id must be 1-8 alphanumeric characters");
+    return;
+  }
+  if (!parseRenderProfile(request.args.profile, profile)) {
+    sendBadRequest(request, "profile must be full, lite, static or auto");
+    return;
+  }
+  displayReportFor(id).assignedProfile = profile;
+  Serial.printf("[Displays] %s assigned profile '%s'.\n", id, renderProfileName(profile));
+  char reply[48];
+  snprintf(reply, sizeof(reply), "Display %s profile: %s", id,
+           profile == RenderProfile::Unset ? "auto" : renderProfileName(profile));
+  request.response.send(200, "text/plain", reply);
+}
+
+void handleDisplaysEndpoint(const HttpRequest& request) {
+  String body = buildDisplayReportsJson();
+  request.response.send(200, "application/json", body.c_str(), body.length(), NO_STORE_HEADER);
+}
+
+void appendHistogramJson(String& body, const LatencyHistogram& histogram) {
+  char count[12];
+  for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+    snprintf(count, sizeof(count), "%c%lu", i == 0 ? '[' : ',', static_cast<unsigned long>(histogram.counts[i]));
+    body += count;
+  }
+  body += ']';
+}
+
+void appendTelemetryJson(String& body, const ClientRegistry::Telemetry& telemetry) {
+  char counters[96];
+  snprintf(counters, sizeof(counters), "{\"reports\":%lu,\"droppedFrames\":%lu,\"errors\":%lu,\"fetchMs\":",
+           static_cast<unsigned long>(telemetry.reports), static_cast<unsigned long>(telemetry.droppedFrames),
+           static_cast<unsigned long>(telemetry.errors));
+  body += counters;
+  appendHistogramJson(body, telemetry.fetchMs);
+  body += ",\"renderMs\":";
+  appendHistogramJson(body, telemetry.renderMs);
+  body += '}';
+}
+
+// Every client in the registry: address, id, when it was last heard from, its
+// traffic and errors, the smoothed interval between its polls, the render
+// latency it reports and its telemetry totals.
+void handleClientsEndpoint(const HttpRequest& request) {
+  String body;
+  body.reserve(48 + 400 * ClientRegistry::MAX_CLIENTS);
+  char head[48];
+  snprintf(head, sizeof(head), "{\"evictions\":%lu,\"clients\":[", static_cast<unsigned long>(clients.evictions()));
+  body += head;
+  uint32_t now = millis();
+  bool first = true;
+  for (size_t i = 0; i < clients.capacity(); ++i) {
+    const ClientRegistry::Client& client = clients.at(i);
+    if (client.ip == 0) {
+      continue;
+    }
+    const uint8_t* ip = reinterpret_cast<const uint8_t*>(&client.ip);
+    char entry[256];
+    snprintf(entry, sizeof(entry),
+             "%s{\"ip\":\"%u.%u.%u.%u\",\"id\":\"%s\",\"seenMs\":%lu,\"ageS\":%lu,\"requests\":%lu,"
+             "\"bytes\":%lu,\"errors\":%lu,\"polls\":%lu,\"pollMs\":%lu,\"renderMs\":%u,\"maxRenderMs\":%u,"
+             "\"telemetry\":",
+             first ? "" : ",", ip[0], ip[1], ip[2], ip[3], client.id,
+             static_cast<unsigned long>(now - client.lastSeenMs),
+             static_cast<unsigned long>((now - client.firstSeenMs) / 1000), static_cast<unsigned long>(client.requests),
+             static_cast<unsigned long>(client.bytes), static_cast<unsigned long>(client.errors),
+             static_cast<unsigned long>(client.polls), static_cast<unsigned long>(client.pollIntervalMs),
+             static_cast<unsigned>(client.renderMs), static_cast<unsigned>(client.maxRenderMs));
+    body += entry;
+    appendTelemetryJson(body, client.telemetry);
+    body += '}';
+    first = false;
+  }
+  body += "]}";
+  request.response.send(200, "application/json", body.c_str(), body.length(), NO_STORE_HEADER);
+}
+
+// Beacon from web/telemetry.js: what the script measured since its last one.
+void handleTelemetryEndpoint(const HttpRequest& request) {
+  const RequestArgs& args = request.args;
+  if (!isValidDisplayId(args.client)) {
+    sendBadRequest(request, "c must be 1-8 alphanumeric characters");
+    return;
+  }
+  if (!args.has(RequestArgs::FETCH_TIMES) || !args.has(RequestArgs::RENDER_TIMES)) {
+    sendBadRequest(request, "f and rt must each be 9 comma-separated bucket counts");
+    return;
+  }
+  if (args.droppedFrames > MAX_TELEMETRY_COUNT || args.clientErrors > MAX_TELEMETRY_COUNT) {
+    sendBadRequest(request, "df or e out of range");
+    return;
+  }
+  ClientRegistry::Telemetry report = {};
+  report.fetchMs = args.fetchTimes;
+  report.renderMs = args.renderTimes;
+  report.droppedFrames = static_cast<uint32_t>(args.droppedFrames);
+  report.errors = static_cast<uint32_t>(args.clientErrors);
+  clients.recordTelemetry(request.client, report);
+  request.response.send(204, "text/plain", "");
+}
+
+// All beacons so far, summed over every client, with the bucket bounds to read them by.
+void handleTelemetryStatsEndpoint(const HttpRequest& request) {
+  String body;
+  body.reserve(256);
+  body += "{\"bucketsMs\":[";
+  for (size_t i = 0; i + 1 < LatencyHistogram::BUCKETS; ++i) {
+    if (i > 0) {
+      body += ',';
+    }
+    body += LatencyHistogram::BOUNDS_MS[i];
+  }
+  body += "],\"totals\":";
+  appendTelemetryJson(body, clients.totals());
+  body += '}';
+  request.response.send(200, "application/json", body.c_str(), body.length(), NO_STORE_HEADER);
+}
+
+const char* requestPriorityName(RequestPriority priority) {
+  switch (priority) {
+    case RequestPriority::Control:
+      return "control";
+    case RequestPriority::Poll:
+      return "poll";
+    case RequestPriority::Page:
+    default:
+      return "page";
+  }
+}
+
+const char BOOT_MARK_FIRST_REQUEST[] = "first-request";
+const char HOLDING_PAGE_HTML[] PROGMEM =
+    "<!DOCTYPE html><html><head><meta charset='utf-8'><meta http-equiv='refresh' content='1'>"
+    "<title>Mission Control</title></head><body style='background:#0f172a;color:#e2e8f0;"
+    "font-family:sans-serif;text-align:center;padding-top:40vh'>Mission Control is starting&hellip;</body></html>";
+
+void handleBootProfileEndpoint(const HttpRequest& request);
+
+// Answers while startup is still running: pages get a holding page that reloads
+// itself, everything else a 503 that dcd.js already knows to wait out. Assets
+// need no game state and are served as usual.
+bool admitDuringStartup(const Route& route, HttpResponse& response) {
+  bootProfile.markOnce(BOOT_MARK_FIRST_REQUEST);
+  if (startupComplete || route.asset != nullptr || route.handler == handleBootProfileEndpoint) {
+    return true;
+  }
+  if (route.priority == RequestPriority::Page) {
+    response.sendStatic(200, "text/html", reinterpret_cast<const uint8_t*>(HOLDING_PAGE_HTML),
+                        sizeof(HOLDING_PAGE_HTML) - 1, NO_STORE_HEADER);
+  } else {
+    response.send(503, "text/plain", "Starting", 8, "Retry-After: 1\r\n");
+  }
+  return false;
+}
+
+// Lets a request through unless free heap (or, with HubHttpServer, a lasting
+// page backlog) is too tight for its class. Control requests and hashed assets,
+// which are written straight from flash, are never shed; shed requests get a
+// fixed 503 with Retry-After, built without allocating.
+bool admitRequest(const Route& route, HttpResponse& response) {
+  if (!admitDuringStartup(route, response)) {
+    return false;
+  }
+  uint32_t freeHeap = ESP.getFreeHeap();
+  if (freeHeap < admissionStats.minFreeHeap) {
+    admissionStats.minFreeHeap = freeHeap;
+  }
+  size_t level = static_cast<size_t>(route.priority);
+  bool shed = false;
+  if (route.asset != nullptr) {
+    shed = false;
+  } else if (route.priority == RequestPriority::Page) {
+    shed = freeHeap < SHED_PAGE_BELOW_FREE_HEAP;
+#if HUB_HTTP_SERVER == HUB_HTTP_SERVER_HUBHTTP
+    shed = shed || server.pageBacklogPasses() >= SHED_PAGE_BACKLOG_PASSES;
+#endif
+  } else if (route.priority == RequestPriority::Poll) {
+    shed = freeHeap < SHED_POLL_BELOW_FREE_HEAP;
+  }
+  if (!shed) {
+    ++admissionStats.admitted[level];
+    return true;
+  }
+  ++admissionStats.shed[level];
+  char headers[32];
+  snprintf(headers, sizeof(headers), "Retry-After: %u\r\n",
+           route.priority == RequestPriority::Page ? RETRY_AFTER_PAGE_S : RETRY_AFTER_POLL_S);
+  response.send(503, "text/plain", "Busy", 4, headers);
+  return false;
+}
+
+// Admission and scheduling counters, per priority class, plus the server's own
+// connection statistics when HubHttpServer is compiled in.
+void handleHttpStatsEndpoint(const HttpRequest& request) {
+  char body[1024];
+  const HubDnsResponder::Stats& dns = dnsResponder.stats();
+  int length = snprintf(body, sizeof(body),
+                        "{\"heap\":%lu,\"minHeap\":%lu,\"probes\":%lu,"
+                        "\"dns\":{\"queries\":%lu,\"answered\":%lu,\"noData\":%lu,\"nxDomain\":%lu,"
+                        "\"malformed\":%lu},\"classes\":{",
+                        static_cast<unsigned long>(ESP.getFreeHeap()),
+                        static_cast<unsigned long>(admissionStats.minFreeHeap), static_cast<unsigned long>(probeHits),
+                        static_cast<unsigned long>(dns.queries), static_cast<unsigned long>(dns.answered),
+                        static_cast<unsigned long>(dns.noData), static_cast<unsigned long>(dns.nxDomain),
+                        static_cast<unsigned long>(dns.malformed));
+  for (size_t level = 0; level < REQUEST_PRIORITY_CLASSES && length < static_cast<int>(sizeof(body)); ++level) {
+    length += snprintf(body + length, sizeof(body) - length, "%s\"%s\":{\"admitted\":%lu,\"shed\":%lu}",
+                       level ? "," : "", requestPriorityName(static_cast<RequestPriority>(level)),
+                       static_cast<unsigned long>(admissionStats.admitted[level]),
+                       static_cast<unsigned long>(admissionStats.shed[level]));
+  }
+  if (length < static_cast<int>(sizeof(body))) {
+#if HUB_HTTP_SERVER == HUB_HTTP_SERVER_HUBHTTP
+    const HubHttpServer::Stats& stats = server.stats();
+    length += snprintf(body + length, sizeof(body) - length,
+                       "},\"server\":{\"active\":%u,\"accepted\":%lu,\"requests\":%lu,\"pipelined\":%lu,"
+                       "\"deferred\":%lu,\"evictedIdle\":%lu,\"timedOut\":%lu,\"malformed\":%lu,"
+                       "\"socketErrors\":%lu}}",
+                       static_cast<unsigned>(server.activeConnections()), static_cast<unsigned long>(stats.accepted),
+                       static_cast<unsigned long>(stats.requests), static_cast<unsigned long>(stats.pipelined),
+                       static_cast<unsigned long>(stats.deferred), static_cast<unsigned long>(stats.evictedIdle),
+                       static_cast<unsigned long>(stats.timedOut), static_cast<unsigned long>(stats.malformed),
+                       static_cast<unsigned long>(stats.socketErrors));
+#else
+    length += snprintf(body + length, sizeof(body) - length, "}}");
+#endif
+  }
+  if (length >= static_cast<int>(sizeof(body))) {
+    request.response.send(500, "text/plain", "HTTP stats too long");
+    return;
+  }
+  request.response.send(200, "application/json", body, length, NO_STORE_HEADER);
+}
+
+const char* latchSourceName(LatchActuator::Source source) {
+  switch (source) {
+    case LatchActuator::Source::FinalButton:
+      return "final-button";
+    case LatchActuator::Source::Game:
+      return "game";
+    case LatchActuator::Source::None:
+    default:
+      return "none";
   }
 }
 
+// Latch task state and press-to-actuation latency, in microseconds.
+void handleLatchStatsEndpoint(const HttpRequest& request) {
+  LatchActuator::Stats stats = latch.stats();
+  char body[160];
+  int length = snprintf(body, sizeof(body),
+                        "{\"fired\":%lu,\"active\":%u,\"armed\":%u,\"source\":\"%s\",\"lastUs\":%lu,"
+                        "\"maxUs\":%lu}",
+                        static_cast<unsigned long>(stats.fired), stats.active ? 1u : 0u,
+                        static_cast<unsigned>(stats.armedButton), latchSourceName(stats.lastSource),
+                        static_cast<unsigned long>(stats.lastLatencyUs), static_cast<unsigned long>(stats.maxLatencyUs));
+  request.response.send(200, "application/json", body, length, NO_STORE_HEADER);
+}
+
+// Per-job run counts, budget overruns and timings of the loop scheduler.
+void handleJobStatsEndpoint(const HttpRequest& request) {
+  char body[896];
+  const LoopScheduler::PassStats& pass = loopJobs.passStats();
+  int length = snprintf(body, sizeof(body), "{\"passes\":%lu,\"lastUs\":%lu,\"maxUs\":%lu,\"jobs\":[",
+                        static_cast<unsigned long>(pass.passes), static_cast<unsigned long>(pass.lastUs),
+                        static_cast<unsigned long>(pass.maxUs));
+  for (size_t i = 0; i < loopJobs.jobCount() && length < static_cast<int>(sizeof(body)); ++i) {
+    const LoopScheduler::JobStats& job = loopJobs.jobStats(i);
+    uint32_t averageUs = job.runs ? static_cast<uint32_t>(job.totalUs / job.runs) : 0;
+    length += snprintf(body + length, sizeof(body) - length,
+                       "%s{\"name\":\"%s\",\"budgetUs\":%lu,\"runs\":%lu,\"overruns\":%lu,\"avgUs\":%lu,"
+                       "\"maxUs\":%lu}",
+                       i ? "," : "", job.name, static_cast<unsigned long>(job.budgetUs),
+                       static_cast<unsigned long>(job.runs), static_cast<unsigned long>(job.overruns),
+                       static_cast<unsigned long>(averageUs), static_cast<unsigned long>(job.maxUs));
+  }
+  if (length < static_cast<int>(sizeof(body))) {
+    length += snprintf(body + length, sizeof(body) - length, "]}");
+  }
+  if (length >= static_cast<int>(sizeof(body))) {
+    request.response.send(500, "text/plain", "Job list too long");
+    return;
+  }
+  request.response.send(200, "application/json", body, length, NO_STORE_HEADER);
+}
+
+// Startup phases in the order they finished, in microseconds since reset, and
+// each one's own duration. "http" is when the holding page became reachable,
+// "ready" when the game was; "first-request" shows when a client first got in.
+void handleBootProfileEndpoint(const HttpRequest& request) {
+  char body[1024];
+  int length = snprintf(body, sizeof(body), "{\"ready\":%s,\"overflows\":%lu,\"marks\":[",
+                        startupComplete ? "true" : "false", static_cast<unsigned long>(bootProfile.overflows()));
+  uint32_t previousUs = 0;
+  for (size_t i = 0; i < bootProfile.count() && length < static_cast<int>(sizeof(body)); ++i) {
+    const BootProfile::Mark& mark = bootProfile.markAt(i);
+    length += snprintf(body + length, sizeof(body) - length, "%s{\"name\":\"%s\",\"atUs\":%lu,\"stepUs\":%lu}",
+                       i ? "," : "", mark.name, static_cast<unsigned long>(mark.atUs),
+                       static_cast<unsigned long>(mark.atUs - previousUs));
+    previousUs = mark.atUs;
+  }
+  if (length < static_cast<int>(sizeof(body))) {
+    length += snprintf(body + length, sizeof(body) - length, "]}");
+  }
+  if (length >= static_cast<int>(sizeof(body))) {
+    request.response.send(500, "text/plain", "Boot profile too long");
+    return;
+  }
+  request.response.send(200, "application/json", body, length, NO_STORE_HEADER);
+}
+
+const char* channelSourceName(ChannelSource source) {
+  switch (source) {
+    case ChannelSource::Override:
+      return "override";
+    case ChannelSource::Scan:
+      return "scan";
+    case ChannelSource::Kept:
+      return "kept";
+    case ChannelSource::Fallback:
+    default:
+      return "fallback";
+  }
+}
+
+// The access point's channel, why it was chosen and, after a scan at this boot,
+// the networks heard and every channel's congestion score (lower is better).
+void handleWifiStatsEndpoint(const HttpRequest& request) {
+  char body[384];
+  int length = snprintf(body, sizeof(body),
+                        "{\"channel\":%u,\"source\":\"%s\",\"stations\":%u,\"networks\":%u,\"scores\":[",
+                        static_cast<unsigned>(wifiChannel), channelSourceName(wifiChannelSource),
+                        static_cast<unsigned>(WiFi.softAPgetStationNum()),
+                        static_cast<unsigned>(channelPlanner.networkCount()));
+  for (uint8_t channel = ChannelPlanner::MIN_CHANNEL;
+       channel <= ChannelPlanner::MAX_CHANNEL && length < static_cast<int>(sizeof(body)); ++channel) {
+    length += snprintf(body + length, sizeof(body) - length, "%s%lu", channel > ChannelPlanner::MIN_CHANNEL ? "," : "",
+                       static_cast<unsigned long>(channelPlanner.scoreOf(channel)));
+  }
+  if (length < static_cast<int>(sizeof(body))) {
+    length += snprintf(body + length, sizeof(body) - length, "]}");
+  }
+  if (length >= static_cast<int>(sizeof(body))) {
+    request.response.send(500, "text/plain", "WiFi stats too long");
+    return;
+  }
+  request.response.send(200, "application/json", body, length, NO_STORE_HEADER);
+}
+
+const char* snapshotSourceName(GameSnapshotStore::Source source) {
+  switch (source) {
+    case GameSnapshotStore::Source::Rtc:
+      return "rtc";
+    case GameSnapshotStore::Source::Nvs:
+      return "nvs";
+    case GameSnapshotStore::Source::None:
+    default:
+      return "none";
+  }
+}
+
+void handleSnapshotStatsEndpoint(const HttpRequest& request) {
+  const GameSnapshotStore::Stats& stats = snapshotStore.stats();
+  char body[128];
+  int length = snprintf(body, sizeof(body),
+                        "{\"restoredFrom\":\"%s\",\"saves\":%lu,\"nvsWrites\":%lu,\"nvsErrors\":%lu}",
+                        snapshotSourceName(stats.restoredFrom), static_cast<unsigned long>(stats.saves),
+                        static_cast<unsigned long>(stats.nvsWrites), static_cast<unsigned long>(stats.nvsErrors));
+  request.response.send(200, "application/json", body, length, NO_STORE_HEADER);
+}
+
+size_t readHistoryFile(void* context, uint8_t* out, size_t capacity) {
+  return static_cast<File*>(context)->read(out, capacity);
+}
+
+void sendHistorySessionList(const HttpRequest& request) {
+  const HistoryLog::Stats& stats = history.stats();
+  char body[512];
+  int length = snprintf(body, sizeof(body),
+                        "{\"current\":%lu,\"records\":%lu,\"pageWrites\":%lu,\"partialWrites\":%lu,"
+                        "\"writeErrors\":%lu,\"gaps\":%lu,\"maxWriteUs\":%lu,\"sessions\":[",
+                        static_cast<unsigned long>(history.currentSession()), static_cast<unsigned long>(stats.records),
+                        static_cast<unsigned long>(stats.pageWrites), static_cast<unsigned long>(stats.partialWrites),
+                        static_cast<unsigned long>(stats.writeErrors), static_cast<unsigned long>(stats.gaps),
+                        static_cast<unsigned long>(stats.maxWriteUs));
+  bool first = true;
+  for (uint32_t session = history.firstSession();
+       session <= history.currentSession() && length < static_cast<int>(sizeof(body)); ++session) {
+    File file;
+    if (!history.openSession(session, file)) {
+      continue;
+    }
+    length += snprintf(body + length, sizeof(body) - length, "%s{\"n\":%lu,\"bytes\":%lu}", first ? "" : ",",
+                       static_cast<unsigned long>(session), static_cast<unsigned long>(file.size()));
+    file.close();
+    first = false;
+  }
+  if (length < static_cast<int>(sizeof(body))) {
+    length += snprintf(body + length, sizeof(body) - length, "]}");
+  }
+  if (length >= static_cast<int>(sizeof(body))) {
+    request.response.send(500, "text/plain", "Session list too long");
+    return;
+  }
+  request.response.send(200, "application/json", body, length, NO_STORE_HEADER);
+}
+
+// Without a session argument, lists the sessions kept on flash. With one, streams
+// that session's file (HistoryLog::FileHeader, then 12-byte GameEvent records)
+// straight from flash; scripts/history_dump.py decodes it.
+void handleHistoryEndpoint(const HttpRequest& request) {
+  if (!history.ready()) {
+    request.response.send(503, "text/plain", "History unavailable");
+    return;
+  }
+  if (!request.args.has(RequestArgs::SESSION)) {
+    sendHistorySessionList(request);
+    return;
+  }
+  uint32_t session = static_cast<uint32_t>(request.args.sessionNumber);
+  if (session == history.currentSession()) {
+    history.flush();
+  }
+  File file;
+  if (!history.openSession(session, file)) {
+    sendNotFound(request.response);
+    return;
+  }
+  char headers[128];
+  snprintf(headers, sizeof(headers),
+           "Cache-Control: no-store\r\nContent-Disposition: attachment; filename=\"session-%lu.bin\"\r\n",
+           static_cast<unsigned long>(session));
+  request.response.sendStream(200, "application/octet-stream", file.size(), readHistoryFile, &file, headers);
+  file.close();
+}
+
+void handleInputStatsEndpoint(const HttpRequest& request) {
+  InputEngine::Stats stats = buttonInput.stats();
+  const UdpInputServer::Stats& udp = udpInput.stats();
+  char body[640];
+  int length = snprintf(body, sizeof(body),
+                        "{\"gpio\":{\"edges\":%lu,\"edgeOverflows\":%lu,\"bounces\":%lu,\"resyncs\":%lu,"
+                        "\"presses\":%lu,\"rateLimited\":%lu,\"pressOverflows\":%lu,\"injected\":%lu,"
+                        "\"injectOverflows\":%lu},"
+                        "\"udp\":{\"packets\":%lu,\"presses\":%lu,\"duplicates\":%lu,\"rejected\":%lu,"
+                        "\"busy\":%lu,\"rateLimited\":%lu,\"malformed\":%lu,\"nodeEvictions\":%lu,"
+                        "\"maxProcessUs\":%lu}}",
+                        static_cast<unsigned long>(stats.edges), static_cast<unsigned long>(stats.edgeOverflows),
+                        static_cast<unsigned long>(stats.bounces), static_cast<unsigned long>(stats.resyncs),
+                        static_cast<unsigned long>(stats.presses), static_cast<unsigned long>(stats.rateLimited),
+                        static_cast<unsigned long>(stats.pressOverflows), static_cast<unsigned long>(stats.injected),
+                        static_cast<unsigned long>(stats.injectOverflows), static_cast<unsigned long>(udp.packets),
+                        static_cast<unsigned long>(udp.presses), static_cast<unsigned long>(udp.duplicates),
+                        static_cast<unsigned long>(udp.rejected), static_cast<unsigned long>(udp.busy),
+                        static_cast<unsigned long>(udp.rateLimited), static_cast<unsigned long>(udp.malformed),
+                        static_cast<unsigned long>(udp.nodeEvictions), static_cast<unsigned long>(udp.maxProcessUs));
+  request.response.send(200, "application/json", body, length, NO_STORE_HEADER);
+}
+
+constexpr Route ROUTES[] = {
+    {HttpMethod::Get, "/", RequestPriority::Page, handleRoot, nullptr},
+    {HttpMethod::Get, "/state", RequestPriority::Poll, handleStateEndpoint, nullptr},
+    {HttpMethod::Get, "/clock", RequestPriority::Poll, handleClockEndpoint, nullptr},
+    {HttpMethod::Get, "/control", RequestPriority::Page, handleControlPanel, nullptr},
+    {HttpMethod::Get, "/remote", RequestPriority::Control, handleRemoteEndpoint, nullptr},
+    {HttpMethod::Get, "/puzzle-button", RequestPriority::Control, handlePuzzleButtonEndpoint, nullptr},
+    {HttpMethod::Get, "/confirm-conduits", RequestPriority::Control, handleConfirmConduitsEndpoint, nullptr},
+    {HttpMethod::Get, "/batch", RequestPriority::Control, handleBatchEndpoint, nullptr},
+    {HttpMethod::Post, "/batch", RequestPriority::Control, handleBatchEndpoint, nullptr},
+    {HttpMethod::Get, "/display-report", RequestPriority::Poll, handleDisplayReportEndpoint, nullptr},
+    {HttpMethod::Get, "/display-profile", RequestPriority::Control, handleDisplayProfileEndpoint, nullptr},
+    {HttpMethod::Get, "/displays", RequestPriority::Poll, handleDisplaysEndpoint, nullptr},
+    {HttpMethod::Post, "/telemetry", RequestPriority::Poll, handleTelemetryEndpoint, nullptr},
+    {HttpMethod::Get, "/debug/http", RequestPriority::Control, handleHttpStatsEndpoint, nullptr},
+    {HttpMethod::Get, "/debug/latch", RequestPriority::Control, handleLatchStatsEndpoint, nullptr},
+    {HttpMethod::Get, "/debug/input", RequestPriority::Control, handleInputStatsEndpoint, nullptr},
+    {HttpMethod::Get, "/debug/jobs", RequestPriority::Control, handleJobStatsEndpoint, nullptr},
+    {HttpMethod::Get, "/debug/snapshot", RequestPriority::Control, handleSnapshotStatsEndpoint, nullptr},
+    {HttpMethod::Get, "/debug/boot", RequestPriority::Control, handleBootProfileEndpoint, nullptr},
+    {HttpMethod::Get, "/debug/wifi", RequestPriority::Control, handleWifiStatsEndpoint, nullptr},
+    {HttpMethod::Get, "/debug/clients", RequestPriority::Control, handleClientsEndpoint, nullptr},
+    {HttpMethod::Get, "/debug/telemetry", RequestPriority::Control, handleTelemetryStatsEndpoint, nullptr},
+    {HttpMethod::Get, "/history", RequestPriority::Page, handleHistoryEndpoint, nullptr},
+    {HttpMethod::Get, web_assets::HUB_CSS.path, RequestPriority::Page, handleAssetRoute, &web_assets::HUB_CSS},
+    {HttpMethod::Get, web_assets::DCD_JS.path, RequestPriority::Page, handleAssetRoute, &web_assets::DCD_JS},
+    {HttpMethod::Get, web_assets::GM_JS.path, RequestPriority::Page, handleAssetRoute, &web_assets::GM_JS},
+    {HttpMethod::Get, web_assets::CLOCK_JS.path, RequestPriority::Page, handleAssetRoute, &web_assets::CLOCK_JS},
+    {HttpMethod::Get, web_assets::TELEMETRY_JS.path, RequestPriority::Page, handleAssetRoute,
+     &web_assets::TELEMETRY_JS},
+};
+constexpr auto ROUTE_INDEX = route_table::build<ROUTE_TABLE_SLOTS>(ROUTES);
+static_assert(ROUTE_INDEX.seed != route_table::NO_SEED, "ROUTES has a duplicate entry or needs more slots");
+
+constexpr size_t countRoutedAssets() {
+  size_t count = 0;
+  for (const web_assets::Asset& asset : web_assets::ALL) {
+    count += asset.path != nullptr ? 1 : 0;
+  }
+  return count;
+}
+static_assert(countRoutedAssets() == 5, "Add a ROUTES entry for each new hashed asset in web/");
+
+const char PROBE_SUCCESS_HTML[] = "<HTML><HEAD><TITLE>Success</TITLE></HEAD><BODY>Success</BODY></HTML>";
+const char PROBE_NO_STORE[] = "Cache-Control: no-store\r\n";
+const char FAVICON_CACHE[] = "Cache-Control: public, max-age=31536000, immutable\r\n";
+
+// Each OS gets exactly the reply its connectivity check expects, so phones and
+// tablets treat the AP as a working network and stop re-probing it. The probe
+// hosts reach the hub through PROBE_HOSTS in the DNS responder.
+constexpr ProbeRoute PROBE_ROUTES[] = {
+    {HttpMethod::Get, "/generate_204", 204, "text/plain", "", PROBE_NO_STORE},                // Android, Chrome OS
+    {HttpMethod::Get, "/gen_204", 204, "text/plain", "", PROBE_NO_STORE},                     // Android
+    {HttpMethod::Get, "/hotspot-detect.html", 200, "text/html", PROBE_SUCCESS_HTML, PROBE_NO_STORE},   // Apple
+    {HttpMethod::Get, "/library/test/success.html", 200, "text/html", PROBE_SUCCESS_HTML, PROBE_NO_STORE},
+    {HttpMethod::Get, "/connecttest.txt", 200, "text/plain", "Microsoft Connect Test", PROBE_NO_STORE},  // Windows
+    {HttpMethod::Get, "/ncsi.txt", 200, "text/plain", "Microsoft NCSI", PROBE_NO_STORE},                 // Windows
+    {HttpMethod::Get, "/success.txt", 200, "text/plain", "success\n", PROBE_NO_STORE},                   // Firefox
+    {HttpMethod::Get, "/favicon.ico", 204, "image/x-icon", "", FAVICON_CACHE},
+};
+constexpr auto PROBE_INDEX = route_table::build<PROBE_TABLE_SLOTS>(PROBE_ROUTES);
+static_assert(PROBE_INDEX.seed != route_table::NO_SEED, "PROBE_ROUTES has a duplicate entry or needs more slots");
+
+const char* const DNS_NAMES[] = {
+    HUB_DNS_NAME,
+    "connectivitycheck.gstatic.com",
+    "connectivitycheck.android.com",
+    "clients3.google.com",
+    "captive.apple.com",
+    "www.apple.com",
+    "www.msftconnecttest.com",
+    "www.msftncsi.com",
+    "detectportal.firefox.com",
+};
+
+// Answers a probe from PROBE_ROUTES; false when the path is not a known probe.
+bool sendProbeResponse(HttpMethod method, const char* path, size_t length, HttpResponse& response) {
+  const ProbeRoute* probe = route_table::find(PROBE_INDEX, PROBE_ROUTES, method, path, length);
+  if (probe == nullptr) {
+    return false;
+  }
+  ++probeHits;
+  response.send(probe->status, probe->contentType, probe->body, strlen(probe->body), probe->headers);
+  return true;
+}
+
+void copyArgText(char* out, size_t size, const char* value, bool& truncated) {
+  size_t length = strlen(value);
+  if (length >= size) {
+    length = size - 1;
+    truncated = true;
+  }
+  memcpy(out, value, length);
+  out[length] = '\0';
+}
+
+// Stores one query argument in its typed slot; unknown names are ignored.
+// Reads LatencyHistogram::BUCKETS comma-separated counts, as web/telemetry.js
+// sends them; anything else leaves the argument absent.
+bool parseBucketCounts(const char* text, LatencyHistogram& histogram) {
+  for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+    char* end = nullptr;
+    unsigned long count = strtoul(text, &end, 10);
+    char separator = i + 1 < LatencyHistogram::BUCKETS ? ',' : '\0';
+    if (end == text || *end != separator || count > MAX_TELEMETRY_COUNT) {
+      return false;
+    }
+    histogram.counts[i] = static_cast<uint32_t>(count);
+    text = end + 1;
+  }
+  return true;
+}
+
+void assignRequestArg(RequestArgs& args, const char* name, const char* value) {
+  if (strcmp(name, "btn") == 0) {
+    args.present |= RequestArgs::BTN;
+    args.btn = value[0];
+  } else if (strcmp(name, "id") == 0) {
+    args.present |= RequestArgs::ID;
+    args.idNumber = strtol(value, nullptr, 10);
+    copyArgText(args.id, sizeof(args.id), value, args.truncated);
+  } else if (strcmp(name, "cmds") == 0) {
+    args.present |= RequestArgs::CMDS;
+    copyArgText(args.cmds, sizeof(args.cmds), value, args.truncated);
+  } else if (strcmp(name, "profile") == 0) {
+    args.present |= RequestArgs::PROFILE;
+    copyArgText(args.profile, sizeof(args.profile), value, args.truncated);
+  } else if (strcmp(name, "fps") == 0) {
+    args.present |= RequestArgs::FPS;
+    args.fps = strtof(value, nullptr);
+  } else if (strcmp(name, "session") == 0) {
+    args.present |= RequestArgs::SESSION;
+    args.sessionNumber = strtoul(value, nullptr, 10);
+  } else if (strcmp(name, "c") == 0) {
+    args.present |= RequestArgs::CLIENT;
+    copyArgText(args.client, sizeof(args.client), value, args.truncated);
+  } else if (strcmp(name, "r") == 0) {
+    args.present |= RequestArgs::RENDER;
+    args.renderMs = strtoul(value, nullptr, 10);
+  } else if (strcmp(name, "f") == 0) {
+    if (parseBucketCounts(value, args.fetchTimes)) {
+      args.present |= RequestArgs::FETCH_TIMES;
+    }
+  } else if (strcmp(name, "rt") == 0) {
+    if (parseBucketCounts(value, args.renderTimes)) {
+      args.present |= RequestArgs::RENDER_TIMES;
+    }
+  } else if (strcmp(name, "df") == 0) {
+    args.present |= RequestArgs::DROPPED_FRAMES;
+    args.droppedFrames = strtoul(value, nullptr, 10);
+  } else if (strcmp(name, "e") == 0) {
+    args.present |= RequestArgs::CLIENT_ERRORS;
+    args.clientErrors = strtoul(value, nullptr, 10);
+  }
+}
+
+// Common tail of both dispatchers: the client is found in the registry, then
+// admission and the handler run and the request is charged to the client.
+void serveRoute(const Route& route, uint32_t remoteIp, const RequestArgs& args, const char* ifNoneMatch,
+                HttpResponse& response) {
+  const char* clientId = isValidDisplayId(args.client) ? args.client : "";
+  ClientRegistry::Client& client = clients.lookup(remoteIp, clientId, millis());
+  MeteredResponse metered(response);
+  if (admitRequest(route, metered)) {
+    route.handler({route, args, ifNoneMatch, client, metered});
+  }
+  uint32_t now = millis();
+  clients.recordRequest(client, route.priority == RequestPriority::Poll, metered.bodyBytes(), metered.status(), now);
+  if (args.has(RequestArgs::RENDER)) {
+    clients.recordRenderLatency(client, args.renderMs);
+  }
+}
+
+#if HUB_HTTP_SERVER == HUB_HTTP_SERVER_HUBHTTP
+
+// HubHttpServer hands over the raw path and query; the route is resolved through
+// ROUTE_INDEX and the query decoded straight into RequestArgs.
+void dispatchHubHttpRequest(const HubHttpRequest& raw, HttpResponse& response) {
+  const Route* route = route_table::find(ROUTE_INDEX, ROUTES, raw.method, raw.path, raw.pathLength);
+  if (route == nullptr) {
+    if (!sendProbeResponse(raw.method, raw.path, raw.pathLength, response)) {
+      sendNotFound(response);
+    }
+    return;
+  }
+  RequestArgs args;
+  forEachQueryArg(raw.query, raw.queryLength,
+                  [&args](const char* name, const char* value) { assignRequestArg(args, name, value); });
+  serveRoute(*route, raw.remoteIp, args, raw.ifNoneMatch, response);
+}
+
+// Probes are answered with canned bytes, as cheap as a poll; anything else
+// unknown gets no better than a page load.
+RequestPriority classifyHubHttpRequest(HttpMethod method, const char* path, size_t pathLength) {
+  const Route* route = route_table::find(ROUTE_INDEX, ROUTES, method, path, pathLength);
+  if (route != nullptr) {
+    return route->priority;
+  }
+  if (route_table::find(PROBE_INDEX, PROBE_ROUTES, method, path, pathLength) != nullptr) {
+    return RequestPriority::Poll;
+  }
+  return RequestPriority::Page;
+}
+
+void configureRoutes() {
+  server.onClassify(classifyHubHttpRequest);
+  server.onRequest(dispatchHubHttpRequest);
+}
+
+#else
+
+// Writes responses for the Arduino WebServer build through its current client,
+// so handlers and static assets take the same raw path in both builds.
+class WebServerResponse : public HttpResponse {
+ public:
+  void send(int status, const char* contentType, const char* body, size_t length,
+            const char* extraHeaders) override {
+    if (writeHead(status, contentType, length, extraHeaders)) {
+      server.client().write(reinterpret_cast<const uint8_t*>(body), length);
+    }
+  }
+
+  void sendStatic(int status, const char* contentType, const uint8_t* body, size_t length,
+                  const char* extraHeaders) override {
+    if (writeHead(status, contentType, length, extraHeaders)) {
+      server.client().write(body, length);
+    }
+  }
+
+  void sendStream(int status, const char* contentType, size_t length, HttpBodyReader reader, void* context,
+                  const char* extraHeaders) override {
+    if (!writeHead(status, contentType, length, extraHeaders)) {
+      return;
+    }
+    uint8_t chunk[512];
+    while (length > 0) {
+      size_t read = reader(context, chunk, length < sizeof(chunk) ? length : sizeof(chunk));
+      if (read == 0) {
+        server.client().stop();
+        return;
+      }
+      server.client().write(chunk, read);
+      length -= read;
+    }
+  }
+
+ private:
+  bool writeHead(int status, const char* contentType, size_t length, const char* extraHeaders) {
+    char head[384];
+    size_t headLength = formatResponseHead(head, sizeof(head), status, contentType, length, extraHeaders, false);
+    if (headLength == 0) {
+      server.send(500, "text/plain", "Response header too large");
+      return false;
+    }
+    server.client().write(reinterpret_cast<const uint8_t*>(head), headLength);
+    return true;
+  }
+};
+
+WebServerResponse webServerResponse;
+
+// Sole WebServer handler: resolves the route through ROUTE_INDEX instead of the
+// server's linear handler list, then parses the arguments once for the handler.
+class RouteTableHandler : public RequestHandler {
+ public:
+  bool canHandle(HTTPMethod method, String uri) override {
+    matched_ = nullptr;
+    if (method == HTTP_GET || method == HTTP_POST) {
+      HttpMethod routeMethod = method == HTTP_POST ? HttpMethod::Post : HttpMethod::Get;
+      matched_ = route_table::find(ROUTE_INDEX, ROUTES, routeMethod, uri.c_str(), uri.length());
+    }
+    return matched_ != nullptr;
+  }
+
+  bool handle(WebServer& web, HTTPMethod, String) override {
+    if (matched_ == nullptr) {
+      return false;
+    }
+    RequestArgs args;
+    for (int i = 0; i < web.args(); ++i) {
+      assignRequestArg(args, web.argName(i).c_str(), web.arg(i).c_str());
+    }
+    String ifNoneMatch = web.header(F("If-None-Match"));
+    serveRoute(*matched_, static_cast<uint32_t>(web.client().remoteIP()), args, ifNoneMatch.c_str(),
+               webServerResponse);
+    return true;
+  }
+
+ private:
+  const Route* matched_ = nullptr;
+};
+
+RouteTableHandler routeTableHandler;
+
 void handleNotFound() {
-  server.send(404, "text/plain", "Endpoint not found");
+  String uri = server.uri();
+  HttpMethod method = server.method() == HTTP_POST ? HttpMethod::Post : HttpMethod::Get;
+  if (!sendProbeResponse(method, uri.c_str(), uri.length(), webServerResponse)) {
+    sendNotFound(webServerResponse);
+  }
 }
 
 void configureRoutes() {
-  server.on("/", HTTP_GET, handleRoot);
-  server.on("/dcd-fragment", HTTP_GET, handleDcdFragment);
-  server.on("/control", HTTP_GET, handleControlPanel);
-  server.on("/remote", HTTP_GET, handleRemoteEndpoint);
-  server.on("/puzzle-button", HTTP_GET, handlePuzzleButtonEndpoint);
-  server.on("/confirm-conduits", HTTP_GET, handleConfirmConduitsEndpoint);
+  server.addHandler(&routeTableHandler);
+  static const char* collectedHeaders[] = {"If-None-Match"};
+  server.collectHeaders(collectedHeaders, sizeof(collectedHeaders) / sizeof(collectedHeaders[0]));
   server.onNotFound(handleNotFound);
 }
 
+#endif
+
+void sendGmSocketState(uint8_t client) {
+  char message[144];
+  int length = formatStateJson(message, sizeof(message), "state");
+  gmSocket.sendTXT(client, message, length);
+}
+
+// "since <bootId> <cursor>" subscribes a GM panel to the event feed. A panel that
+// reconnects passes the boot id and next sequence number it last saw and only gets
+// what it missed; anything else (first load, hub rebooted) starts at the oldest
+// event still in the ring.
+void handleGmSocketSubscribe(uint8_t client, const char* args) {
+  char* cursorStart = nullptr;
+  unsigned long clientBootId = strtoul(args, &cursorStart, 10);
+  unsigned long cursor = strtoul(cursorStart, nullptr, 10);
+  gmEventCursors[client] = clientBootId == bootId ? cursor : eventLog.oldestSeq();
+}
+
+// Streams events each subscribed GM panel has not seen yet as binary frames: an
+// 8-byte header (u8 format version, u8 flags, u16 count, u32 boot id) followed by
+// count GameEvent records. Sends at most one batch per client per call so a
+// catch-up never stalls the loop.
+void streamGameEvents() {
+  for (uint8_t client = 0; client < WEBSOCKETS_SERVER_CLIENT_MAX; ++client) {
+    uint32_t& cursor = gmEventCursors[client];
+    if (cursor == NO_EVENT_CURSOR || cursor == eventLog.nextSeq()) {
+      continue;
+    }
+    uint8_t frame[8 + EVENT_STREAM_BATCH * sizeof(GameEvent)];
+    bool dropped = false;
+    size_t count = eventLog.read(cursor, reinterpret_cast<GameEvent*>(frame + 8), EVENT_STREAM_BATCH, dropped);
+    frame[0] = EVENT_FRAME_VERSION;
+    frame[1] = dropped ? EVENT_FRAME_FLAG_DROPPED : 0;
+    frame[2] = static_cast<uint8_t>(count & 0xff);
+    frame[3] = static_cast<uint8_t>(count >> 8);
+    memcpy(frame + 4, &bootId, sizeof(bootId));
+    gmSocket.sendBIN(client, frame, 8 + count * sizeof(GameEvent));
+  }
+}
+
+// GM socket frames are "<seq> <cmd>" (see parseGmCommand); each one is answered
+// with an ack carrying the same reply text as the HTTP endpoint.
+void handleGmSocketCommand(uint8_t client, const char* payload, size_t length) {
+  if (strncmp(payload, "since ", 6) == 0) {
+    handleGmSocketSubscribe(client, payload + 6);
+    return;
+  }
+  char* cmdStart = nullptr;
+  unsigned long seq = strtoul(payload, &cmdStart, 10);
+  GmCommand command;
+  char reply[64];
+  bool ok = cmdStart != payload && *cmdStart == ' ' &&
+            parseGmCommand(cmdStart + 1, length - (cmdStart + 1 - payload), command);
+  if (ok) {
+    runGmCommand(command, reply, sizeof(reply));
+  } else {
+    snprintf(reply, sizeof(reply), "unknown command");
+  }
+  char message[112];
+  int messageLength = snprintf(message, sizeof(message), "{\"t\":\"ack\",\"q\":%lu,\"ok\":%s,\"m\":\"%s\"}",
+                               seq, ok ? "true" : "false", reply);
+  gmSocket.sendTXT(client, message, messageLength);
+}
+
+void handleGmSocketEvent(uint8_t client, WStype_t type, uint8_t* payload, size_t length) {
+  switch (type) {
+    case WStype_CONNECTED:
+      gmEventCursors[client] = NO_EVENT_CURSOR;
+      Serial.printf("[Socket] GM panel %u connected.\n", client);
+      sendGmSocketState(client);
+      break;
+    case WStype_DISCONNECTED:
+      gmEventCursors[client] = NO_EVENT_CURSOR;
+      Serial.printf("[Socket] GM panel %u disconnected.\n", client);
+      break;
+    case WStype_TEXT:
+      handleGmSocketCommand(client, reinterpret_cast<const char*>(payload), length);
+      break;
+    default:
+      break;
+  }
+}
+
+// Pushes the state snapshot to every GM panel once per change, however many
+// mutations happened since the last loop iteration.
+void broadcastStateIfChanged() {
+  if (stateVersion == lastBroadcastVersion) {
+    return;
+  }
+  lastBroadcastVersion = stateVersion;
+  char message[144];
+  int length = formatStateJson(message, sizeof(message), "state");
+  gmSocket.broadcastTXT(message, length);
+}
+
+void IRAM_ATTR wakeInputTask(void*) {
+  if (inputTask == nullptr) {
+    return;
+  }
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(inputTask, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+// Accepted presses reach the latch here, ahead of the game logic in the loop.
+// The arming only reflects presses the game has applied, so it is only trusted
+// when no earlier press is still waiting; otherwise the game fires the latch.
+void forwardPressToLatch(void*, const InputEngine::Press& press) {
+  if (!buttonInput.pressesPending()) {
+    latch.onButtonEdge(press.button, press.timestampUs);
+  }
+}
+
+// Runs the debounce stage as soon as the edge ISR wakes it, and keeps polling
+// while a debounce window is open so the closing re-read happens on time.
+void inputTaskMain(void*) {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, buttonInput.hasOpenWindows() ? pdMS_TO_TICKS(INPUT_WINDOW_POLL_MS) : portMAX_DELAY);
+    buttonInput.process();
+  }
+}
+
+void startButtonInput() {
+  buttonInput.onPress(forwardPressToLatch, nullptr);
+  buttonInput.onEdge(wakeInputTask, nullptr);
+  if (xTaskCreatePinnedToCore(inputTaskMain, "input", INPUT_TASK_STACK_SIZE, nullptr, INPUT_TASK_PRIORITY, &inputTask,
+                              LatchActuator::TASK_CORE) != pdPASS) {
+    Serial.println(F("[Buttons] Failed to start input task."));
+    return;
+  }
+  buttonInput.begin();
+}
+
+// Wireless presses join the wired ones in InputEngine, so both are ordered and
+// rate-capped together and reach the latch fast path and the game the same way.
+// udpInputJob() acks each one once the input task has ruled on it.
+bool queueUdpPress(uint8_t button, uint32_t receivedAtUs, uint8_t tag) {
+  if (inputTask == nullptr || !buttonInput.injectPress(button, receivedAtUs, tag)) {
+    return false;
+  }
+  xTaskNotifyGive(inputTask);
+  return true;
+}
+
+// Loop jobs, in the order they run each pass; see registerLoopJobs().
+void buttonPressJob(void*, uint32_t deadlineUs) {
+  InputEngine::Press press;
+  do {
+    if (!buttonInput.peekPress(press)) {
+      return;
+    }
+    registerButtonPress(press.button, press.timestampUs);
+    buttonInput.donePress();
+  } while (loopJobs.withinBudget(deadlineUs));
+}
+
+void udpInputJob(void*, uint32_t) {
+  InputEngine::InjectResult result;
+  while (buttonInput.nextInjectResult(result)) {
+    UdpInputServer::Outcome outcome = UdpInputServer::Outcome::Applied;
+    if (result.outcome == InputEngine::InjectOutcome::RateLimited) {
+      outcome = UdpInputServer::Outcome::RateLimited;
+    } else if (result.outcome == InputEngine::InjectOutcome::Overflow) {
+      outcome = UdpInputServer::Outcome::Busy;
+    }
+    udpInput.completePress(result.tag, outcome);
+  }
+  udpInput.processPackets();
+}
+
+void gameTimerJob(void*, uint32_t) {
+  gameTimers.advance(millis());
+}
+
+void gmSocketJob(void*, uint32_t) {
+  gmSocket.loop();
+  broadcastStateIfChanged();
+  streamGameEvents();
+}
+
+void httpJob(void*, uint32_t) {
+  server.handleClient();
+}
+
+void dnsJob(void*, uint32_t) {
+  dnsResponder.processQueries();
+}
+
+// Moves new events into the history page, or writes the page out when it is due;
+// one flash write at most per run.
+void historyJob(void*, uint32_t) {
+  if (!history.ready()) {
+    return;
+  }
+  uint32_t now = millis();
+  if (history.flushDue(now)) {
+    history.flush();
+    return;
+  }
+  GameEvent event;
+  bool dropped = false;
+  while (!history.full() && eventLog.read(historyCursor, &event, 1, dropped) == 1) {
+    if (dropped) {
+      history.noteGap();
+    }
+    if (event.type == static_cast<uint8_t>(GameEventType::Reset)) {
+      history.startSession();
+    }
+    history.add(event, now);
+  }
+}
+
+// State changes reach RTC memory as they happen; this picks up the seconds of a
+// running clock and lets the store write NVS when a write is due.
+void snapshotJob(void*, uint32_t) {
+  snapshotStore.save(captureGameSnapshot(), millis());
+  snapshotStore.flush(millis());
+}
+
+// Puts the room back where it was before a reset. Runs as the first startup
+// stage, after the access point and HTTP server are up but before any input
+// source or the GM socket starts; until startup completes, requests that touch
+// game state get the holding page or a 503, so nothing sees the game before it
+// is restored. Returns true when a game in progress was restored.
+bool restoreGameSnapshot() {
+  if (!snapshotStore.begin()) {
+    Serial.println(F("[Snapshot] NVS unavailable; only resets that keep power are survived."));
+  }
+  GameSnapshot snapshot;
+  if (!snapshotStore.restore(snapshot)) {
+    Serial.println(F("[Snapshot] No saved game; starting at Puzzle 1."));
+    return false;
+  }
+  if (snapshot.state > static_cast<uint8_t>(GameState::MissionComplete) ||
+      snapshot.nextSequenceIndex > BUTTON_SEQUENCE_LENGTH ||
+      snapshot.clockSeconds * 1000UL > MISSION_CLOCK_MAX_MS) {
+    Serial.println(F("[Snapshot] Saved game out of range; starting at Puzzle 1."));
+    return false;
+  }
+  currentState = static_cast<GameState>(snapshot.state);
+  conduitsVerified = snapshot.conduitsVerified;
+  latchTriggered = snapshot.latchTriggered;
+  nextSequenceIndex = snapshot.nextSequenceIndex;
+  updateLatchArming();
+  setMissionClock(snapshot.clockRunning, snapshot.clockSeconds * 1000UL, snapshot.clockRunning ? 's' : 'p');
+  logGameEvent(GameEventType::Restored, snapshot.state, static_cast<uint8_t>(snapshotStore.stats().restoredFrom));
+  if (currentState == GameState::Puzzle3 && nextSequenceIndex >= BUTTON_SEQUENCE_LENGTH) {
+    // Reset between the last correct press and completeMission(): the sequence
+    // was entered in full, so finish the mission rather than read past it.
+    completeMission(micros());
+  }
+  Serial.printf("[Snapshot] Restored state %u, step %u/%u from %s.\n", static_cast<unsigned>(snapshot.state),
+                static_cast<unsigned>(nextSequenceIndex), static_cast<unsigned>(BUTTON_SEQUENCE_LENGTH),
+                snapshotSourceName(snapshotStore.stats().restoredFrom));
+  return true;
+}
+
+// Inputs first, then the timers they may have armed, then the GM channel ahead
+// of display traffic. Budgets are what a healthy pass should take; /debug/jobs
+// counts the runs that exceed them.
+void registerLoopJobs() {
+  loopJobs.addJob("buttons", buttonPressJob, nullptr, 0, 1000);
+  loopJobs.addJob("udp", udpInputJob, nullptr, 0, 1000);
+  loopJobs.addJob("timers", gameTimerJob, nullptr, 0, 500);
+  loopJobs.addJob("gm-socket", gmSocketJob, nullptr, 0, 5000);
+  loopJobs.addJob("http", httpJob, nullptr, 0, 20000);
+  loopJobs.addJob("dns", dnsJob, nullptr, 20, 1000);
+  // An NVS write that has to erase a flash page takes tens of milliseconds.
+  loopJobs.addJob("snapshot", snapshotJob, nullptr, 250, 30000);
+  loopJobs.addJob("history", historyJob, nullptr, 100, 30000);
+}
+
+void selectWifiChannel() {
+  if (HUB_WIFI_CHANNEL != 0) {
+    wifiChannel = HUB_WIFI_CHANNEL;
+    wifiChannelSource = ChannelSource::Override;
+    return;
+  }
+  uint8_t kept = static_cast<uint8_t>(rtcChannelRecord & 0xFF);
+  if ((rtcChannelRecord & ~0xFFu) == RTC_CHANNEL_MAGIC && kept >= ChannelPlanner::MIN_CHANNEL &&
+      kept <= ChannelPlanner::MAX_CHANNEL) {
+    wifiChannel = kept;
+    wifiChannelSource = ChannelSource::Kept;
+    return;
+  }
+  wifiChannel = channelPlanner.plan(HUB_FALLBACK_CHANNEL);
+  if (!channelPlanner.scanned()) {
+    wifiChannelSource = ChannelSource::Fallback;
+    return;
+  }
+  wifiChannelSource = ChannelSource::Scan;
+  rtcChannelRecord = RTC_CHANNEL_MAGIC | wifiChannel;
+}
+
+// The timer wheel starts here, when the loop takes over from setup(), rather
+// than before the channel scan and access point; nothing schedules a timer
+// earlier than the restore.
+void restoreStage() {
+  gameTimers.start(millis());
+  resumedGame = restoreGameSnapshot();
+}
+
+void startUdpInput() {
+  if (udpInput.begin(queueUdpPress)) {
+    Serial.printf("[Buttons] UDP input listening on port %u.\n", udp_input::PORT);
+  } else {
+    Serial.println(F("[Buttons] Failed to open UDP input port."));
+  }
+}
+
+void startGmSocket() {
+  gmSocket.onEvent(handleGmSocketEvent);
+  gmSocket.begin();
+  Serial.printf("[Socket] GM socket listening on port %u.\n", GM_SOCKET_PORT);
+}
+
+void startHistory() {
+  if (history.begin(bootId, resumedGame)) {
+    Serial.printf("[History] Recording session %lu.\n", static_cast<unsigned long>(history.currentSession()));
+  } else {
+    Serial.println(F("[History] LittleFS unavailable; session history disabled."));
+  }
+}
+
+struct StartupStage {
+  const char* name;
+  void (*run)();
+};
+
+// Everything setup() leaves until the access point, DNS and HTTP server are up.
+// The game state is restored before any input can reach it.
+constexpr StartupStage STARTUP_STAGES[] = {
+    {"restore", restoreStage},
+    {"buttons", startButtonInput},
+    {"udp", startUdpInput},
+    {"gm-socket", startGmSocket},
+    {"history", startHistory},
+};
+
+// Runs one stage per loop pass, so the holding page is served in between; the
+// last one hands the loop over to the job scheduler.
+void runStartupStage() {
+  const StartupStage& stage = STARTUP_STAGES[nextStartupStage++];
+  stage.run();
+  bootProfile.mark(stage.name);
+  if (nextStartupStage < sizeof(STARTUP_STAGES) / sizeof(STARTUP_STAGES[0])) {
+    return;
+  }
+  registerLoopJobs();
+  startupComplete = true;
+  bootProfile.mark("ready");
+  Serial.printf("[Boot] Ready %lu ms after reset.\n", static_cast<unsigned long>(micros() / 1000));
+}
+
 }  // namespace
 
 void setup() {
   Serial.begin(115200);
   Serial.println();
   Serial.println(F("Mission Control Hub booting..."));
+  bootProfile.mark("serial");
+  stateVersion = esp_random();
+  missionClock.version = esp_random();
+  bootId = esp_random();
+  for (uint32_t& cursor : gmEventCursors) {
+    cursor = NO_EVENT_CURSOR;
+  }
+  if (!latch.begin(LATCH_PIN, LATCH_PULSE_MS)) {
+    Serial.println(F("[Latch] Failed to start latch task."));
+  }
+  bootProfile.mark("latch");
 
+  selectWifiChannel();
+  bootProfile.mark("channel");
   WiFi.mode(WIFI_AP);
-  if (WiFi.softAP(HUB_SSID, HUB_PASSWORD, HUB_CHANNEL)) {
+  if (WiFi.softAP(HUB_SSID, HUB_PASSWORD, wifiChannel)) {
     Serial.print(F("[WiFi] Access point ready: "));
     Serial.println(HUB_SSID);
+    Serial.printf("[WiFi] Channel %u (%s, %u networks heard).\n", static_cast<unsigned>(wifiChannel),
+                  channelSourceName(wifiChannelSource), static_cast<unsigned>(channelPlanner.networkCount()));
     Serial.print(F("[WiFi] IP address: "));
     Serial.println(WiFi.softAPIP());
   } else {
     Serial.println(F("[WiFi] Failed to start access point."));
   }
+  bootProfile.mark("wifi");
+
+  if (dnsResponder.begin(WiFi.softAPIP(), DNS_NAMES, sizeof(DNS_NAMES) / sizeof(DNS_NAMES[0]))) {
+    Serial.printf("[DNS] Answering %s and OS probe hosts.\n", HUB_DNS_NAME);
+  } else {
+    Serial.println(F("[DNS] Failed to open port 53."));
+  }
+  bootProfile.mark("dns");
 
   configureRoutes();
   server.begin();
-  Serial.println(F("[Server] HTTP server started on port 80."));
+  Serial.println(F("[Server] HTTP server started on port 80; holding page until startup finishes."));
+  bootProfile.mark("http");
 }
 
 void loop() {
-  server.handleClient();
+  if (!startupComplete) {
+    runStartupStage();
+    server.handleClient();
+    dnsResponder.processQueries();
+    return;
+  }
+  loopJobs.runOnce();
 }
@@ -0,0 +1,168 @@
+#include "udp_input.h"
+
+using udp_input::AckStatus;
+using udp_input::MessageType;
+using udp_input::Packet;
+
+bool UdpInputServer::begin(PressHandler handler) {
+  handler_ = handler;
+  return udp_.begin(udp_input::PORT) == 1;
+}
+
+UdpInputServer::Node& UdpInputServer::nodeFor(uint8_t id, uint16_t session) {
+  Node* slot = nullptr;
+  for (Node& node : nodes_) {
+    if (node.id == id) {
+      slot = &node;
+      break;
+    }
+    if (slot == nullptr && node.id == 0) {
+      slot = &node;
+    }
+  }
+  if (slot == nullptr) {
+    slot = &nodes_[0];
+    for (Node& node : nodes_) {
+      if ((long)(node.lastHeardMs - slot->lastHeardMs) < 0) {
+        slot = &node;
+      }
+    }
+    ++stats_.nodeEvictions;
+  }
+  if (slot->id != id || slot->session != session) {
+    // New node, or the node restarted: its sequence numbers begin again.
+    slot->id = id;
+    slot->session = session;
+    slot->window = 0;
+  }
+  slot->lastHeardMs = millis();
+  return *slot;
+}
+
+// Returns true when seq is new for the node and records it.
+bool UdpInputServer::markSeen(Node& node, uint16_t seq) {
+  if (node.window == 0) {
+    node.highestSeq = seq;
+    node.window = 1;
+    return true;
+  }
+  int16_t ahead = static_cast<int16_t>(seq - node.highestSeq);
+  if (ahead > 0) {
+    node.window = ahead >= REPLAY_WINDOW ? 0 : node.window << ahead;
+    node.window |= 1;
+    node.highestSeq = seq;
+    return true;
+  }
+  uint16_t behind = static_cast<uint16_t>(-ahead);
+  if (behind >= REPLAY_WINDOW) {
+    return false;  // Too old to tell; a retransmit this late was applied long ago.
+  }
+  uint32_t bit = 1u << behind;
+  if ((node.window & bit) != 0) {
+    return false;
+  }
+  node.window |= bit;
+  return true;
+}
+
+// Undoes markSeen() for a press that was not applied, so its retransmit is.
+void UdpInputServer::forget(Node& node, uint16_t seq) {
+  uint16_t behind = static_cast<uint16_t>(node.highestSeq - seq);
+  if (behind < REPLAY_WINDOW) {
+    node.window &= ~(1u << behind);
+  }
+}
+
+// The queued press this packet is a copy of, if it is still waiting for its ack.
+UdpInputServer::Pending* UdpInputServer::pendingFor(const Packet& packet) {
+  for (Pending& pending : pending_) {
+    if (pending.used && pending.packet.nodeId == packet.nodeId && pending.packet.session == packet.session &&
+        pending.packet.seq == packet.seq) {
+      return &pending;
+    }
+  }
+  return nullptr;
+}
+
+void UdpInputServer::sendAck(const IPAddress& address, uint16_t port, Packet& packet, AckStatus status) {
+  packet.type = static_cast<uint8_t>(MessageType::Ack);
+  packet.status = static_cast<uint8_t>(status);
+  udp_.beginPacket(address, port);
+  udp_.write(reinterpret_cast<const uint8_t*>(&packet), sizeof(packet));
+  udp_.endPacket();
+}
+
+void UdpInputServer::processPackets() {
+  for (size_t i = 0; i < MAX_PACKETS_PER_CALL; ++i) {
+    int size = udp_.parsePacket();
+    if (size <= 0) {
+      return;
+    }
+    uint32_t receivedAtUs = micros();
+    ++stats_.packets;
+    Packet packet;
+    if (size != sizeof(packet) || udp_.read(reinterpret_cast<uint8_t*>(&packet), sizeof(packet)) != size ||
+        packet.magic != udp_input::MAGIC || packet.version != udp_input::VERSION ||
+        packet.type != static_cast<uint8_t>(MessageType::Press) || packet.nodeId == 0) {
+      ++stats_.malformed;
+      continue;
+    }
+    if (packet.button < 1 || packet.button > 5) {
+      ++stats_.rejected;
+      sendAck(udp_.remoteIP(), udp_.remotePort(), packet, AckStatus::Rejected);
+      continue;
+    }
+    Node& node = nodeFor(packet.nodeId, packet.session);
+    if (!markSeen(node, packet.seq)) {
+      ++stats_.duplicates;
+      if (pendingFor(packet) == nullptr) {  // Otherwise the verdict's ack answers this copy too.
+        sendAck(udp_.remoteIP(), udp_.remotePort(), packet, AckStatus::Duplicate);
+      }
+      continue;
+    }
+    size_t tag = 0;
+    while (tag < MAX_PENDING && pending_[tag].used) {
+      ++tag;
+    }
+    if (tag == MAX_PENDING || handler_ == nullptr ||
+        !handler_(packet.button, receivedAtUs, static_cast<uint8_t>(tag))) {
+      forget(node, packet.seq);
+      ++stats_.busy;
+      sendAck(udp_.remoteIP(), udp_.remotePort(), packet, AckStatus::Busy);
+      continue;
+    }
+    pending_[tag] = {true, udp_.remoteIP(), udp_.remotePort(), receivedAtUs, packet};
+  }
+}
+
+void UdpInputServer::completePress(uint8_t tag, Outcome outcome) {
+  if (tag >= MAX_PENDING || !pending_[tag].used) {
+    return;
+  }
+  Pending& pending = pending_[tag];
+  pending.used = false;
+  switch (outcome) {
+    case Outcome::Applied: {
+      ++stats_.presses;
+      sendAck(pending.address, pending.port, pending.packet, AckStatus::Applied);
+      uint32_t elapsedUs = micros() - pending.receivedAtUs;
+      if (elapsedUs > stats_.maxProcessUs) {
+        stats_.maxProcessUs = elapsedUs;
+      }
+      break;
+    }
+    case Outcome::RateLimited:
+      ++stats_.rateLimited;
+      sendAck(pending.address, pending.port, pending.packet, AckStatus::RateLimited);
+      break;
+    case Outcome::Busy:
+      for (Node& node : nodes_) {
+        if (node.id == pending.packet.nodeId && node.session == pending.packet.session) {
+          forget(node, pending.packet.seq);
+        }
+      }
+      ++stats_.busy;
+      sendAck(pending.address, pending.port, pending.packet, AckStatus::Busy);
+      break;
+  }
+}
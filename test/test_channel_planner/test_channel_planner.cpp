@@ -0,0 +1,108 @@
+#include <unity.h>
+
+#include "channel_planner.h"
+
+namespace {
+
+// A fixed survey of a venue, or a failed scan.
+class FakeWifiScanner : public WifiScanner {
+ public:
+  FakeWifiScanner(const ScannedNetwork* networks, size_t count) : networks_(networks), count_(count) {}
+
+  static FakeWifiScanner failing() {
+    FakeWifiScanner scanner(nullptr, 0);
+    scanner.fail_ = true;
+    return scanner;
+  }
+
+  int scan(ScannedNetwork* out, size_t capacity) override {
+    if (fail_) {
+      return -1;
+    }
+    size_t count = count_ < capacity ? count_ : capacity;
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = networks_[i];
+    }
+    return static_cast<int>(count);
+  }
+
+ private:
+  const ScannedNetwork* networks_;
+  size_t count_;
+  bool fail_ = false;
+};
+
+uint8_t planFor(const ScannedNetwork* networks, size_t count, uint8_t fallbackChannel) {
+  FakeWifiScanner scanner(networks, count);
+  ChannelPlanner planner(scanner);
+  return planner.plan(fallbackChannel);
+}
+
+}  // namespace
+
+void test_failed_scan_keeps_fallback() {
+  FakeWifiScanner scanner = FakeWifiScanner::failing();
+  ChannelPlanner planner(scanner);
+  TEST_ASSERT_EQUAL_UINT8(4, planner.plan(4));
+  TEST_ASSERT_FALSE(planner.scanned());
+  TEST_ASSERT_EQUAL(0, planner.networkCount());
+}
+
+void test_quiet_venue_keeps_fallback_among_equals() {
+  FakeWifiScanner scanner(nullptr, 0);
+  ChannelPlanner planner(scanner);
+  TEST_ASSERT_EQUAL_UINT8(6, planner.plan(6));
+  TEST_ASSERT_TRUE(planner.scanned());
+  // A fallback off 1/6/11 loses the tie to a non-overlapping channel.
+  TEST_ASSERT_EQUAL_UINT8(1, planner.plan(3));
+}
+
+void test_crowded_channels_are_avoided() {
+  const ScannedNetwork venue[] = {
+      {1, -40}, {1, -55}, {1, -70}, {6, -45}, {6, -60}, {11, -85},
+  };
+  TEST_ASSERT_EQUAL_UINT8(11, planFor(venue, sizeof(venue) / sizeof(venue[0]), 1));
+}
+
+void test_overlapping_neighbours_count() {
+  // Nothing sits on 1 or 6, but the loud network on 3 overlaps channel 1 more
+  // than channel 6; channel 11 is crowded.
+  const ScannedNetwork venue[] = {{3, -30}, {11, -30}, {11, -50}};
+  FakeWifiScanner scanner(venue, sizeof(venue) / sizeof(venue[0]));
+  ChannelPlanner planner(scanner);
+  TEST_ASSERT_EQUAL_UINT8(6, planner.plan(1));
+  TEST_ASSERT_TRUE(planner.scoreOf(1) > planner.scoreOf(6));
+  TEST_ASSERT_EQUAL(3, planner.networkCount());
+}
+
+void test_quieter_signal_weighs_less() {
+  // A faint network on 1 beats loud ones on 6 and 11.
+  const ScannedNetwork venue[] = {{1, -92}, {6, -35}, {11, -35}};
+  TEST_ASSERT_EQUAL_UINT8(1, planFor(venue, sizeof(venue) / sizeof(venue[0]), 6));
+}
+
+void test_tie_prefers_non_overlapping_then_fallback() {
+  uint32_t scores[ChannelPlanner::MAX_CHANNEL + 1] = {};
+  for (uint8_t channel = ChannelPlanner::MIN_CHANNEL; channel <= ChannelPlanner::MAX_CHANNEL; ++channel) {
+    scores[channel] = 50;
+  }
+  scores[3] = 10;
+  scores[6] = 10;
+  scores[11] = 10;
+  TEST_ASSERT_EQUAL_UINT8(6, ChannelPlanner::best(scores, 3));
+  TEST_ASSERT_EQUAL_UINT8(11, ChannelPlanner::best(scores, 11));
+  scores[6] = 50;
+  scores[11] = 50;
+  TEST_ASSERT_EQUAL_UINT8(3, ChannelPlanner::best(scores, 6));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_failed_scan_keeps_fallback);
+  RUN_TEST(test_quiet_venue_keeps_fallback_among_equals);
+  RUN_TEST(test_crowded_channels_are_avoided);
+  RUN_TEST(test_overlapping_neighbours_count);
+  RUN_TEST(test_quieter_signal_weighs_less);
+  RUN_TEST(test_tie_prefers_non_overlapping_then_fallback);
+  return UNITY_END();
+}
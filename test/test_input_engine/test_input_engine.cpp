@@ -0,0 +1,208 @@
+#include <unity.h>
+
+#include "input_engine.h"
+
+namespace {
+
+constexpr uint8_t PINS[] = {10, 11, 12, 13, 14};
+constexpr size_t BUTTON_COUNT = sizeof(PINS) / sizeof(PINS[0]);
+constexpr InputEngine::Config CONFIG = {20000, 120000, true};
+constexpr uint32_t BOUNCE_GAP_US = 200;
+
+// Replays synthetic edge traces: every level change runs the pin's edge ISR at
+// the current fake time, the way the interrupt would. Pins idle high, as the
+// buttons are active low.
+class FakeGpioPort : public GpioPort {
+ public:
+  FakeGpioPort() {
+    for (bool& high : high_) {
+      high = true;
+    }
+  }
+
+  void configureInput(uint8_t) override {}
+  bool readHigh(uint8_t pin) override { return high_[pin]; }
+  void attachEdgeInterrupt(uint8_t pin, void (*isr)(void*), void* arg) override {
+    isr_[pin] = isr;
+    arg_[pin] = arg;
+  }
+  uint32_t micros() override { return nowUs_; }
+
+  void setTime(uint32_t nowUs) { nowUs_ = nowUs; }
+
+  void setLevel(uint8_t pin, bool high, uint32_t atUs) {
+    nowUs_ = atUs;
+    if (high_[pin] != high) {
+      high_[pin] = high;
+      isr_[pin](arg_[pin]);
+    }
+  }
+
+  // Contact bounce: the level flips back and forth bounces times, BOUNCE_GAP_US
+  // apart, before it settles at high.
+  void bouncyChange(uint8_t pin, bool high, uint32_t atUs, int bounces) {
+    uint32_t t = atUs;
+    for (int i = 0; i < bounces; ++i) {
+      setLevel(pin, high, t);
+      setLevel(pin, !high, t + BOUNCE_GAP_US);
+      t += 2 * BOUNCE_GAP_US;
+    }
+    setLevel(pin, high, t);
+  }
+
+ private:
+  bool high_[64];
+  void (*isr_[64])(void*) = {};
+  void* arg_[64] = {};
+  uint32_t nowUs_ = 0;
+};
+
+struct Rig {
+  FakeGpioPort gpio;
+  InputEngine engine{gpio, PINS, BUTTON_COUNT, CONFIG};
+
+  Rig() { engine.begin(); }
+
+  void processAt(uint32_t nowUs) {
+    gpio.setTime(nowUs);
+    engine.process();
+  }
+
+  // A bouncy press of button (1-based) at atUs, held for holdUs, with every
+  // debounce window run out.
+  void press(uint8_t button, uint32_t atUs, uint32_t holdUs) {
+    uint8_t pin = PINS[button - 1];
+    gpio.bouncyChange(pin, false, atUs, 4);
+    processAt(atUs + 2000);
+    processAt(atUs + CONFIG.debounceUs + 5000);
+    gpio.bouncyChange(pin, true, atUs + holdUs, 3);
+    processAt(atUs + holdUs + 2000);
+    processAt(atUs + holdUs + CONFIG.debounceUs + 5000);
+  }
+
+  size_t drain(InputEngine::Press* out, size_t capacity) {
+    size_t count = 0;
+    InputEngine::Press press;
+    while (count < capacity && engine.peekPress(press)) {
+      out[count++] = press;
+      engine.donePress();
+    }
+    return count;
+  }
+};
+
+}  // namespace
+
+void test_bouncy_press_counts_once() {
+  Rig rig;
+  rig.press(2, 1000000, 80000);
+
+  InputEngine::Press presses[4];
+  TEST_ASSERT_EQUAL(1, rig.drain(presses, 4));
+  TEST_ASSERT_EQUAL_UINT8(2, presses[0].button);
+  TEST_ASSERT_EQUAL_UINT32(1000000, presses[0].timestampUs);
+  InputEngine::Stats stats = rig.engine.stats();
+  TEST_ASSERT_EQUAL_UINT32(1, stats.presses);
+  TEST_ASSERT_TRUE(stats.bounces > 0);
+  TEST_ASSERT_FALSE(rig.engine.hasOpenWindows());
+}
+
+void test_release_missed_in_bounce_is_resynced() {
+  Rig rig;
+  uint8_t pin = PINS[0];
+  rig.gpio.setLevel(pin, false, 1000000);
+  rig.gpio.setLevel(pin, true, 1005000);  // Let go inside the debounce window.
+  rig.processAt(1006000);
+  rig.processAt(1030000);  // Window closed: the re-read finds the button up.
+  rig.press(1, 1300000, 50000);
+
+  InputEngine::Press presses[4];
+  TEST_ASSERT_EQUAL(2, rig.drain(presses, 4));
+  TEST_ASSERT_EQUAL_UINT32(1, rig.engine.stats().resyncs);
+}
+
+void test_mashed_presses_are_rate_limited() {
+  Rig rig;
+  rig.press(1, 1000000, 30000);
+  rig.press(3, 1050000, 30000);  // 50 ms after the last accepted press.
+  rig.press(5, 1200000, 30000);
+
+  InputEngine::Press presses[4];
+  TEST_ASSERT_EQUAL(2, rig.drain(presses, 4));
+  TEST_ASSERT_EQUAL_UINT8(1, presses[0].button);
+  TEST_ASSERT_EQUAL_UINT8(5, presses[1].button);
+  TEST_ASSERT_EQUAL_UINT32(1, rig.engine.stats().rateLimited);
+}
+
+void test_injected_presses_merge_with_edges_in_time_order() {
+  Rig rig;
+  TEST_ASSERT_TRUE(rig.engine.injectPress(3, 1050000));  // Rate-limited behind the wired press.
+  TEST_ASSERT_TRUE(rig.engine.injectPress(4, 1300000));
+  rig.gpio.setLevel(PINS[0], false, 1000000);  // Queued after the injections, but earlier.
+  rig.processAt(1400000);
+
+  InputEngine::Press presses[4];
+  TEST_ASSERT_EQUAL(2, rig.drain(presses, 4));
+  TEST_ASSERT_EQUAL_UINT8(1, presses[0].button);
+  TEST_ASSERT_EQUAL_UINT8(4, presses[1].button);
+  InputEngine::Stats stats = rig.engine.stats();
+  TEST_ASSERT_EQUAL_UINT32(2, stats.injected);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.rateLimited);
+}
+
+void test_late_injected_press_is_rate_limited() {
+  Rig rig;
+  rig.press(1, 1000000, 30000);
+  TEST_ASSERT_TRUE(rig.engine.injectPress(2, 990000));  // Stamped before the wired press.
+  rig.processAt(1100000);
+
+  InputEngine::Press presses[4];
+  TEST_ASSERT_EQUAL(1, rig.drain(presses, 4));
+  TEST_ASSERT_EQUAL_UINT32(1, rig.engine.stats().rateLimited);
+}
+
+void test_injected_press_outcomes_are_reported() {
+  Rig rig;
+  TEST_ASSERT_TRUE(rig.engine.injectPress(1, 1000000, 7));
+  TEST_ASSERT_TRUE(rig.engine.injectPress(2, 1050000, 8));
+  rig.processAt(1100000);
+
+  InputEngine::InjectResult result;
+  TEST_ASSERT_TRUE(rig.engine.nextInjectResult(result));
+  TEST_ASSERT_EQUAL_UINT8(7, result.tag);
+  TEST_ASSERT_TRUE(result.outcome == InputEngine::InjectOutcome::Accepted);
+  TEST_ASSERT_TRUE(rig.engine.nextInjectResult(result));
+  TEST_ASSERT_EQUAL_UINT8(8, result.tag);
+  TEST_ASSERT_TRUE(result.outcome == InputEngine::InjectOutcome::RateLimited);
+  TEST_ASSERT_FALSE(rig.engine.nextInjectResult(result));
+}
+
+void test_inject_rejects_unknown_buttons() {
+  Rig rig;
+  TEST_ASSERT_FALSE(rig.engine.injectPress(0, 1000));
+  TEST_ASSERT_FALSE(rig.engine.injectPress(BUTTON_COUNT + 1, 1000));
+}
+
+void test_press_stays_pending_until_done() {
+  Rig rig;
+  rig.press(1, 1000000, 30000);
+
+  InputEngine::Press press;
+  TEST_ASSERT_TRUE(rig.engine.peekPress(press));
+  TEST_ASSERT_TRUE(rig.engine.pressesPending());
+  rig.engine.donePress();
+  TEST_ASSERT_FALSE(rig.engine.pressesPending());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_bouncy_press_counts_once);
+  RUN_TEST(test_release_missed_in_bounce_is_resynced);
+  RUN_TEST(test_mashed_presses_are_rate_limited);
+  RUN_TEST(test_injected_presses_merge_with_edges_in_time_order);
+  RUN_TEST(test_late_injected_press_is_rate_limited);
+  RUN_TEST(test_injected_press_outcomes_are_reported);
+  RUN_TEST(test_inject_rejects_unknown_buttons);
+  RUN_TEST(test_press_stays_pending_until_done);
+  return UNITY_END();
+}
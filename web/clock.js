@@ -0,0 +1,84 @@
+// Mission countdown shared by the DCD and GM pages. Served from /assets/<hash>.js.
+// The hub owns the clock and only describes it: the time left at an anchor on its
+// own millis() timeline, and whether it is running. Pages estimate that timeline
+// from /clock round trips (NTP-style; the shortest round trip of a burst wins)
+// and count down locally, so a running clock costs no requests at all. The "k"
+// field of /state and of GM socket state messages tells pages when to re-fetch.
+const CLOCK_FIRST_SYNC_SAMPLES=3;
+// A burst slower than this multiple of the best round trip seen keeps the old offset.
+const CLOCK_RTT_TOLERANCE=4;
+const CLOCK_TICK_MS=250;
+const missionClock={version:null,running:false,remainingAtAnchor:0,anchor:0,offset:null,bestRtt:Infinity,
+  el:null,lastText:null,timer:null,syncing:false};
+
+async function sampleClock(){
+  const t0=performance.now();
+  const resp=await fetch('/clock',{cache:'no-store'});
+  if(!resp.ok){throw new Error('HTTP '+resp.status);}
+  const clock=await resp.json();
+  const t3=performance.now();
+  return {clock,rtt:t3-t0,offset:clock.h-(t0+t3)/2};
+}
+
+function hubNow(){
+  return performance.now()+missionClock.offset;
+}
+
+function clockRemainingMs(){
+  if(!missionClock.running){return missionClock.remainingAtAnchor;}
+  return Math.max(0,missionClock.remainingAtAnchor-(hubNow()-missionClock.anchor));
+}
+
+function formatClock(ms){
+  const total=Math.ceil(ms/1000);
+  return String(Math.floor(total/60)).padStart(2,'0')+':'+String(total%60).padStart(2,'0');
+}
+
+function renderClock(){
+  const el=missionClock.el;
+  if(!el||missionClock.offset===null){return;}
+  const remaining=clockRemainingMs();
+  const text=formatClock(remaining);
+  if(text!==missionClock.lastText){
+    el.textContent=text;
+    missionClock.lastText=text;
+  }
+  el.classList.toggle('paused',!missionClock.running);
+  el.classList.toggle('expired',remaining<=0);
+  el.hidden=false;
+  const ticking=missionClock.running&&remaining>0;
+  if(ticking&&!missionClock.timer){missionClock.timer=setInterval(renderClock,CLOCK_TICK_MS);}
+  else if(!ticking&&missionClock.timer){clearInterval(missionClock.timer);missionClock.timer=null;}
+}
+
+// Re-fetches the clock when its version moved. The first sync takes a few samples
+// to pin down the offset; later ones take one and keep it only if its round trip
+// was not much worse than the best seen.
+async function syncMissionClock(version){
+  if(version===missionClock.version||missionClock.syncing){return;}
+  missionClock.syncing=true;
+  try{
+    const samples=missionClock.offset===null?CLOCK_FIRST_SYNC_SAMPLES:1;
+    let best=null;
+    for(let i=0;i<samples;i++){
+      const sample=await sampleClock();
+      if(!best||sample.rtt<best.rtt){best=sample;}
+    }
+    if(missionClock.offset===null||best.rtt<=missionClock.bestRtt*CLOCK_RTT_TOLERANCE){
+      missionClock.offset=best.offset;
+      missionClock.bestRtt=Math.min(missionClock.bestRtt,best.rtt);
+    }
+    const clock=best.clock;
+    missionClock.version=clock.k;
+    missionClock.running=!!clock.r;
+    missionClock.remainingAtAnchor=clock.m;
+    missionClock.anchor=clock.a;
+    renderClock();
+  }catch(err){}
+  missionClock.syncing=false;
+}
+
+function attachMissionClock(el){
+  missionClock.el=el;
+  renderClock();
+}
@@ -0,0 +1,224 @@
+// DCD display refresh loop. Served from /assets/<hash>.js.
+// Polls the compact /state snapshot and renders it with the <template> blocks
+// in dcd.html, so the hub only ever sends a few dozen bytes per update. Renders
+// patch the live nodes in place: weak display hardware avoids a full re-layout
+// and running CSS animations (.flash-banner, .flash) are not restarted. Poll
+// timings, renders, dropped frames and failures go into the telemetry beacon.
+const statusEl=document.getElementById('sync-status');
+const contentEl=document.getElementById('dcd-content');
+const STATE_TEMPLATES=['tpl-puzzle1','tpl-puzzle2','tpl-puzzle3','tpl-complete'];
+const STATE_PUZZLE2=1;
+const STATE_PUZZLE3=2;
+// A new error extends the flash window by more than poll jitter; re-arm the animation then.
+const ERROR_RESTART_SLACK_MS=300;
+
+let lastVersion=null;
+let mountedTemplate=null;
+let sequenceView=null;
+let errorUntil=0;
+let errorTimer=null;
+
+function templateFor(state){
+  if(state.s===STATE_PUZZLE2&&state.c){return 'tpl-puzzle2-verified';}
+  return STATE_TEMPLATES[state.s];
+}
+
+function mount(templateId){
+  const tpl=document.getElementById(templateId);
+  if(!tpl){contentEl.innerHTML='<p>Unknown state.</p>';}
+  else{contentEl.replaceChildren(tpl.content.cloneNode(true));}
+  mountedTemplate=templateId;
+  sequenceView=null;
+  errorUntil=0;
+  const row=contentEl.querySelector('.sequence-row');
+  if(row){
+    sequenceView={
+      steps:Array.from(row.children),
+      stepClasses:[],
+      digit:contentEl.querySelector('.current-step strong'),
+      alert:contentEl.querySelector('.alert'),
+    };
+  }
+}
+
+function setText(el,text){
+  if(el.textContent!==text){el.textContent=text;}
+}
+
+function hideAlert(){
+  errorTimer=null;
+  errorUntil=0;
+  if(sequenceView){sequenceView.alert.hidden=true;}
+}
+
+function patchAlert(view,remainingMs){
+  const now=Date.now();
+  if(!remainingMs){
+    if(errorTimer){clearTimeout(errorTimer);}
+    hideAlert();
+    return;
+  }
+  const until=now+remainingMs;
+  const isNewError=until>errorUntil+ERROR_RESTART_SLACK_MS;
+  errorUntil=until;
+  if(errorTimer){clearTimeout(errorTimer);}
+  // Expire locally so the banner clears on time even between polls.
+  errorTimer=setTimeout(hideAlert,remainingMs);
+  if(!isNewError&&!view.alert.hidden){return;}
+  view.alert.hidden=false;
+  view.alert.classList.remove('flash');
+  void view.alert.offsetWidth;
+  view.alert.classList.add('flash');
+}
+
+function patchSequence(view,state){
+  view.steps.forEach((step,i)=>{
+    const cls=i<state.n?'done':(i===state.n?'active':'pending');
+    if(view.stepClasses[i]!==cls){
+      step.className='seq-step '+cls;
+      view.stepClasses[i]=cls;
+    }
+  });
+  setText(view.digit,state.n<view.steps.length?view.steps[state.n].textContent:'✓');
+  patchAlert(view,state.e);
+}
+
+function render(state){
+  if(state.v===lastVersion){return;}
+  lastVersion=state.v;
+  const templateId=templateFor(state);
+  if(templateId!==mountedTemplate){mount(templateId);}
+  if(sequenceView&&state.s===STATE_PUZZLE3){patchSequence(sequenceView,state);}
+}
+
+// Polling follows the hub's "p" hint (how soon this state is likely to change),
+// stops while the page is hidden and backs off exponentially after failures.
+const DEFAULT_POLL_MS=700;
+const MIN_POLL_MS=200;
+const MAX_BACKOFF_MS=30000;
+let pollTimer=null;
+let pollInFlight=false;
+// Identifies this display to the hub on every poll (c=), along with how long the
+// previous poll took from request to painted frame (r=).
+const displayId=localStorage.getItem('dcdId')||Math.random().toString(36).slice(2,10).padEnd(8,'0');
+localStorage.setItem('dcdId',displayId);
+let lastRenderMs=null;
+let pollFailures=0;
+
+function schedulePoll(delayMs){
+  clearTimeout(pollTimer);
+  pollTimer=setTimeout(refreshContent,delayMs);
+}
+
+function backoffDelay(){
+  const base=Math.min(MAX_BACKOFF_MS,DEFAULT_POLL_MS*Math.pow(2,pollFailures));
+  return base*(0.75+Math.random()*0.5);
+}
+
+async function refreshContent(){
+  pollTimer=null;
+  if(pollInFlight||document.hidden){return;}
+  pollInFlight=true;
+  let nextPollMs;
+  try{
+    const startedAt=performance.now();
+    const resp=await timedFetch('/state?c='+displayId+(lastRenderMs===null?'':'&r='+lastRenderMs),{cache:'no-store'});
+    if(resp.status===503){
+      // Hub is shedding load; come back when it asks rather than on the backoff curve.
+      pollFailures++;
+      nextPollMs=Math.max(backoffDelay(),(parseInt(resp.headers.get('Retry-After'),10)||1)*1000);
+      statusEl.textContent='Hub busy • retrying';
+      return;
+    }
+    if(!resp.ok){throw new Error('HTTP '+resp.status);}
+    const state=await resp.json();
+    const fetchMs=Math.round(performance.now()-startedAt);
+    const renderStartedAt=performance.now();
+    render(state);
+    requestAnimationFrame(()=>{
+      const paintedAt=performance.now();
+      lastRenderMs=Math.round(paintedAt-startedAt);
+      recordRenderMs(paintedAt-renderStartedAt);
+    });
+    syncMissionClock(state.k);
+    pollFailures=0;
+    nextPollMs=Math.max(MIN_POLL_MS,state.p||DEFAULT_POLL_MS);
+    statusEl.textContent='Link stable • '+fetchMs+' ms • '+new Date().toLocaleTimeString();
+  }catch(err){
+    pollFailures++;
+    nextPollMs=backoffDelay();
+    statusEl.textContent='Link unstable: '+err;
+  }finally{
+    pollInFlight=false;
+    if(!document.hidden){schedulePoll(nextPollMs);}
+  }
+}
+
+document.addEventListener('visibilitychange',()=>{
+  if(document.hidden){clearTimeout(pollTimer);pollTimer=null;}
+  else if(!pollInFlight){schedulePoll(0);}
+});
+
+// Render profile: ?profile= selects one and the device remembers it. A profile the
+// GM assigns comes back in reply to the frame-rate report and takes over from it.
+const PROFILES=['full','lite','static'];
+const FPS_SAMPLE_MS=5000;
+const FPS_REPORT_INTERVAL_MS=30000;
+let profile='full';
+
+function applyProfile(name){
+  if(!PROFILES.includes(name)){return;}
+  document.body.classList.remove('profile-'+profile);
+  profile=name;
+  document.body.classList.add('profile-'+profile);
+  localStorage.setItem('dcdProfile',profile);
+}
+
+// A gap of more than this many frame periods counts the frames it skipped as dropped.
+const DROPPED_FRAME_GAP=1.5;
+
+// Frame periods are measured against the shortest gap in the sample, so a 30 Hz
+// panel is not charged for the frames it never meant to draw. A sample with no
+// gaps (a hidden or stalled page drew at most one frame) has no period to go by.
+function countDroppedFrames(gaps){
+  if(gaps.length===0){return 0;}
+  const period=Math.max(1,Math.min(...gaps));
+  return gaps.reduce((dropped,gap)=>dropped+(gap>period*DROPPED_FRAME_GAP?Math.round(gap/period)-1:0),0);
+}
+
+function sampleFrameRate(){
+  return new Promise(resolve=>{
+    const gaps=[];
+    const start=performance.now();
+    let last=start;
+    function tick(now){
+      gaps.push(now-last);
+      last=now;
+      if(now-start<FPS_SAMPLE_MS){requestAnimationFrame(tick);}
+      else{
+        recordDroppedFrames(countDroppedFrames(gaps.slice(1)));
+        resolve(gaps.length*1000/(now-start));
+      }
+    }
+    requestAnimationFrame(tick);
+  });
+}
+
+async function reportFrameRate(){
+  if(document.hidden){return;}
+  const fps=await sampleFrameRate();
+  try{
+    const resp=await timedFetch('/display-report?c='+displayId+'&profile='+profile+'&fps='+fps.toFixed(1),{cache:'no-store'});
+    if(resp.ok){
+      const assigned=(await resp.text()).trim();
+      if(assigned&&assigned!==profile){applyProfile(assigned);}
+    }
+  }catch(err){}
+}
+
+attachMissionClock(document.getElementById('mission-clock'));
+applyProfile(new URLSearchParams(location.search).get('profile')||localStorage.getItem('dcdProfile')||'full');
+startTelemetry(displayId);
+refreshContent();
+setTimeout(reportFrameRate,FPS_SAMPLE_MS);
+setInterval(reportFrameRate,FPS_REPORT_INTERVAL_MS);
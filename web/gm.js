@@ -0,0 +1,201 @@
+// GM control panel actions. Served from /assets/<hash>.js.
+// Commands travel over a persistent WebSocket to the hub (GM_SOCKET_PORT in
+// main.cpp) as "<seq> <cmd>" text frames; the hub acks each one and pushes the
+// game state whenever it changes. While the socket is down the buttons fall
+// back to the plain HTTP endpoints. Game events arrive on the same socket as
+// binary frames (see streamGameEvents() in main.cpp). Command round trips,
+// event feed renders and link failures go into the telemetry beacon.
+const GM_SOCKET_PORT=81;
+const SOCKET_RETRY_MIN_MS=500;
+const SOCKET_RETRY_MAX_MS=8000;
+const STATE_LABELS=['Puzzle 1 — Message Decoding','Puzzle 2 — Power Conduits','Puzzle 3 — Button Sequence','Mission Complete'];
+const STATE_SHORT_NAMES=['Puzzle 1','Puzzle 2','Puzzle 3','Complete'];
+const EVENT_RECORD_BYTES=12;
+const EVENT_FRAME_HEADER_BYTES=8;
+const EVENT_FLAG_DROPPED=0x01;
+const EVENT_FEED_LIMIT=100;
+const EVENT_TRANSITION=1,EVENT_BUTTON_PRESS=2,EVENT_CONDUIT_CONFIRM=3,EVENT_LATCH_FIRED=4,EVENT_RESET=5,EVENT_REMOTE=6,EVENT_CLOCK=7,EVENT_RESTORED=8;
+const DISPLAY_PROFILES=['auto','full','lite','static'];
+const DISPLAY_REFRESH_MS=10000;
+// A display that has sent nothing for this long has stopped polling.
+const DISPLAY_STALE_S=15;
+const gmClientId=localStorage.getItem('gmId')||('gm'+Math.random().toString(36).slice(2,8)).padEnd(8,'0');
+localStorage.setItem('gmId',gmClientId);
+const statusEl=document.getElementById('status');
+const stateLabelEl=document.getElementById('state-label');
+const linkStatusEl=document.getElementById('link-status');
+const eventFeedEl=document.getElementById('event-feed');
+
+let socket=null;
+let socketRetryMs=SOCKET_RETRY_MIN_MS;
+let nextCommandSeq=1;
+const pendingCommands=new Map();
+// Where the event feed resumes after a reconnect.
+let eventBootId=0;
+let eventCursor=0;
+
+async function sendAction(path){
+  statusEl.textContent='Sending '+path+' ...';
+  try{
+    const resp=await timedFetch(path);
+    const text=await resp.text();
+    statusEl.textContent=text;
+  }catch(err){statusEl.textContent='Error: '+err;}
+}
+
+function sendCommand(cmd,fallbackPath){
+  if(!socket||socket.readyState!==WebSocket.OPEN){
+    sendAction(fallbackPath);
+    return;
+  }
+  const seq=nextCommandSeq++;
+  pendingCommands.set(seq,{cmd,sentAt:performance.now()});
+  statusEl.textContent='Sending '+cmd+' ...';
+  socket.send(seq+' '+cmd);
+}
+
+function showState(state){
+  stateLabelEl.textContent=STATE_LABELS[state.s]||'Unknown';
+  syncMissionClock(state.k);
+}
+
+function handleAck(msg){
+  const pending=pendingCommands.get(msg.q);
+  pendingCommands.delete(msg.q);
+  let rtt='';
+  if(pending){
+    const ms=performance.now()-pending.sentAt;
+    recordFetchMs(ms);
+    rtt=' ('+Math.round(ms)+' ms)';
+  }
+  if(!msg.ok){recordError();}
+  statusEl.textContent=(msg.ok?'':'Rejected: ')+msg.m+rtt;
+}
+
+function formatUptime(ms){
+  const total=Math.floor(ms/1000);
+  const pad=(n)=>String(n).padStart(2,'0');
+  return Math.floor(total/3600)+':'+pad(Math.floor(total/60)%60)+':'+pad(total%60);
+}
+
+const SNAPSHOT_SOURCES=['?','RTC','NVS'];
+const CLOCK_ACTIONS={s:'started',p:'paused',u:'+1 min',d:'−1 min',r:'reset',e:'expired'};
+const CONDUIT_RESULTS=['Conduits confirmed','Conduits already verified','Conduit confirm ignored (not in Puzzle 2)'];
+
+function describeEvent(type,a,b,c){
+  switch(type){
+    case EVENT_TRANSITION:return [STATE_SHORT_NAMES[a]+' → '+STATE_SHORT_NAMES[b],''];
+    case EVENT_BUTTON_PRESS:
+      if(!b){return ['Button '+a+' ignored (not in Puzzle 3)',''];}
+      if(a===b){return ['Button '+a+' correct • '+c+'/15','good'];}
+      return ['Button '+a+' wrong (expected '+b+') • sequence reset','bad'];
+    case EVENT_CONDUIT_CONFIRM:return [CONDUIT_RESULTS[a]||'Conduit confirm',a===0?'good':''];
+    case EVENT_LATCH_FIRED:return ['Latch fired','good'];
+    case EVENT_RESET:return ['Game reset from '+STATE_SHORT_NAMES[a],'bad'];
+    case EVENT_REMOTE:return ['Remote '+String.fromCharCode(a),''];
+    case EVENT_CLOCK:{
+      const action=String.fromCharCode(a);
+      return ['Clock '+(CLOCK_ACTIONS[action]||action)+' • '+b+':'+String(c).padStart(2,'0')+' left',action==='e'?'bad':''];
+    }
+    case EVENT_RESTORED:return ['Restored '+STATE_SHORT_NAMES[a]+' after a reset ('+(SNAPSHOT_SOURCES[b]||'?')+')','bad'];
+    default:return ['Event '+type,''];
+  }
+}
+
+function appendFeedLine(text,cls){
+  const item=document.createElement('li');
+  item.textContent=text;
+  if(cls){item.className=cls;}
+  eventFeedEl.prepend(item);
+  while(eventFeedEl.children.length>EVENT_FEED_LIMIT){eventFeedEl.lastChild.remove();}
+}
+
+function handleEventFrame(buffer){
+  const view=new DataView(buffer);
+  const flags=view.getUint8(1);
+  const count=view.getUint16(2,true);
+  const bootId=view.getUint32(4,true);
+  if(bootId!==eventBootId){
+    eventFeedEl.replaceChildren();
+    eventBootId=bootId;
+  }
+  if(flags&EVENT_FLAG_DROPPED){appendFeedLine('… older events no longer available','');}
+  for(let i=0;i<count;i++){
+    const offset=EVENT_FRAME_HEADER_BYTES+i*EVENT_RECORD_BYTES;
+    const seq=view.getUint32(offset,true);
+    const timestamp=view.getUint32(offset+4,true);
+    const [text,cls]=describeEvent(view.getUint8(offset+8),view.getUint8(offset+9),view.getUint8(offset+10),view.getUint8(offset+11));
+    appendFeedLine(formatUptime(timestamp)+'  '+text,cls);
+    eventCursor=seq+1;
+  }
+}
+
+function connectSocket(){
+  socket=new WebSocket('ws://'+location.hostname+':'+GM_SOCKET_PORT+'/');
+  socket.binaryType='arraybuffer';
+  socket.onopen=()=>{
+    socketRetryMs=SOCKET_RETRY_MIN_MS;
+    linkStatusEl.textContent='• live';
+    socket.send('since '+eventBootId+' '+eventCursor);
+  };
+  socket.onmessage=(event)=>{
+    if(event.data instanceof ArrayBuffer){
+      const startedAt=performance.now();
+      handleEventFrame(event.data);
+      requestAnimationFrame(()=>recordRenderMs(performance.now()-startedAt));
+      return;
+    }
+    const msg=JSON.parse(event.data);
+    if(msg.t==='state'){showState(msg);}
+    else if(msg.t==='ack'){handleAck(msg);}
+  };
+  socket.onclose=()=>{
+    recordError();
+    linkStatusEl.textContent='• reconnecting';
+    pendingCommands.clear();
+    setTimeout(connectSocket,socketRetryMs);
+    socketRetryMs=Math.min(SOCKET_RETRY_MAX_MS,socketRetryMs*2);
+  };
+}
+
+async function assignProfile(id,profile){
+  await sendAction('/display-profile?id='+id+'&profile='+profile);
+  refreshDisplays();
+}
+
+function displayRow(report){
+  const row=document.createElement('div');
+  const stale=report.seen>DISPLAY_STALE_S;
+  row.className='display-row'+(stale?' stale':'');
+  const label=document.createElement('span');
+  label.textContent=report.id+' • '+(report.p||'?')+' • '+report.fps.toFixed(1)+' fps • '+
+    (stale?'STALE, last seen '+report.seen+'s ago':'seen '+report.seen+'s ago');
+  row.appendChild(label);
+  for(const profile of DISPLAY_PROFILES){
+    const btn=document.createElement('button');
+    btn.textContent=profile;
+    if((report.a||'auto')===profile){btn.className='selected';}
+    btn.onclick=()=>assignProfile(report.id,profile);
+    row.appendChild(btn);
+  }
+  return row;
+}
+
+async function refreshDisplays(){
+  const list=document.getElementById('displays');
+  try{
+    const resp=await timedFetch('/displays?c='+gmClientId,{cache:'no-store'});
+    const reports=await resp.json();
+    if(!reports.length){list.textContent='No reports yet.';return;}
+    list.replaceChildren(...reports.map(displayRow));
+  }catch(err){list.textContent='Display list unavailable: '+err;}
+}
+
+document.querySelectorAll('button[data-cmd]').forEach((btn)=>{
+  btn.onclick=()=>sendCommand(btn.dataset.cmd,btn.dataset.path);
+});
+attachMissionClock(document.getElementById('gm-clock'));
+connectSocket();
+startTelemetry(gmClientId);
+refreshDisplays();
+setInterval(refreshDisplays,DISPLAY_REFRESH_MS);
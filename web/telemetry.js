@@ -0,0 +1,72 @@
+// Client telemetry shared by the DCD and GM pages. Served from /assets/<hash>.js.
+// Fetch latency, render time, dropped frames and errors are counted here in the
+// hub's own histogram buckets (LatencyHistogram in include/latency_histogram.h)
+// and posted to /telemetry as one small form every TELEMETRY_INTERVAL_MS, so the
+// hub only ever adds counts up. Nothing is sent while there is nothing to report.
+const TELEMETRY_BOUNDS_MS=[10,25,50,100,250,500,1000,2500];
+const TELEMETRY_INTERVAL_MS=5000;
+const telemetry={clientId:null,fetchMs:null,renderMs:null,droppedFrames:0,errors:0,sending:false};
+
+function resetTelemetry(){
+  const counts={fetchMs:telemetry.fetchMs,renderMs:telemetry.renderMs,droppedFrames:telemetry.droppedFrames,errors:telemetry.errors};
+  telemetry.fetchMs=new Array(TELEMETRY_BOUNDS_MS.length+1).fill(0);
+  telemetry.renderMs=new Array(TELEMETRY_BOUNDS_MS.length+1).fill(0);
+  telemetry.droppedFrames=0;
+  telemetry.errors=0;
+  return counts;
+}
+resetTelemetry();
+
+function telemetryBucket(ms){
+  let i=0;
+  while(i<TELEMETRY_BOUNDS_MS.length&&ms>TELEMETRY_BOUNDS_MS[i]){i++;}
+  return i;
+}
+
+function recordFetchMs(ms){telemetry.fetchMs[telemetryBucket(ms)]++;}
+function recordRenderMs(ms){telemetry.renderMs[telemetryBucket(ms)]++;}
+function recordDroppedFrames(count){telemetry.droppedFrames+=count;}
+function recordError(){telemetry.errors++;}
+
+// fetch() that times itself; a network failure or an error status counts as an error.
+async function timedFetch(url,options){
+  const startedAt=performance.now();
+  try{
+    const resp=await fetch(url,options);
+    recordFetchMs(performance.now()-startedAt);
+    if(!resp.ok){recordError();}
+    return resp;
+  }catch(err){
+    recordError();
+    throw err;
+  }
+}
+
+// Counts go back into the next batch if the hub was unreachable or busy; one it
+// rejected outright is dropped rather than sent again.
+async function sendTelemetry(){
+  const pending=telemetry.fetchMs.concat(telemetry.renderMs).some(count=>count>0)||
+    telemetry.droppedFrames>0||telemetry.errors>0;
+  if(!pending||telemetry.sending||document.hidden){return;}
+  telemetry.sending=true;
+  const batch=resetTelemetry();
+  const body=new URLSearchParams({c:telemetry.clientId,f:batch.fetchMs.join(','),rt:batch.renderMs.join(','),
+    df:batch.droppedFrames,e:batch.errors});
+  let keep=false;
+  try{
+    const resp=await fetch('/telemetry',{method:'POST',body,cache:'no-store'});
+    keep=resp.status===503;
+  }catch(err){keep=true;}
+  if(keep){
+    batch.fetchMs.forEach((count,i)=>{telemetry.fetchMs[i]+=count;});
+    batch.renderMs.forEach((count,i)=>{telemetry.renderMs[i]+=count;});
+    telemetry.droppedFrames+=batch.droppedFrames;
+    telemetry.errors+=batch.errors;
+  }
+  telemetry.sending=false;
+}
+
+function startTelemetry(clientId){
+  telemetry.clientId=clientId;
+  setInterval(sendTelemetry,TELEMETRY_INTERVAL_MS);
+}